@@ -0,0 +1,318 @@
+#ifndef BPLUSTREE_H
+#define BPLUSTREE_H
+#include "PostingList.h"
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+// B+-tree mapping keys to posting lists, with the same interface as DSAvlTree.
+//
+// Every node holds up to MAX_KEYS sorted keys in one contiguous array, so a lookup costs one binary search per
+// level over a few cache lines instead of one pointer chase per key comparison. Keys and their posting lists
+// live only in the leaves; inner nodes hold separators (the first key of the subtree to their right). Leaves
+// are chained left to right, so in-order and range scans walk the leaf level without going back up the tree.
+// Full nodes are split on the way down, so an insert never has to revisit a parent.
+template <typename Comparable, typename Value>
+class BPlusTree
+{
+private:
+    static constexpr size_t MAX_KEYS = 32; // Keys per node
+
+    struct Node
+    {
+        bool leaf;
+        std::vector<Comparable> keys;                // Sorted keys (leaves) or separators (inner nodes)
+        std::vector<PostingList<Value>> postings;    // Leaves only: postings[i] belongs to keys[i]
+        std::vector<Node *> children;                // Inner nodes only: keys.size() + 1 subtrees
+        Node *next;                                  // Leaves only: the leaf to the right
+
+        Node(bool isLeaf) : leaf{isLeaf}, next{nullptr} {}
+        bool full() const { return keys.size() == MAX_KEYS; }
+    };
+
+    Node *root; // Root node, nullptr while the tree is empty
+    int size;   // Number of keys in the tree
+
+    // Splits the full child parent->children[i] in two and adds the separator to parent
+    void splitChild(Node *parent, size_t i)
+    {
+        Node *child = parent->children[i];
+        Node *sibling = new Node(child->leaf);
+        size_t mid = child->keys.size() / 2;
+        Comparable separator;
+        if (child->leaf)
+        {
+            // The right half moves to the new leaf, and its first key becomes the separator
+            sibling->keys.assign(std::make_move_iterator(child->keys.begin() + mid), std::make_move_iterator(child->keys.end()));
+            sibling->postings.assign(std::make_move_iterator(child->postings.begin() + mid), std::make_move_iterator(child->postings.end()));
+            child->keys.resize(mid);
+            child->postings.resize(mid);
+            sibling->next = child->next;
+            child->next = sibling;
+            separator = sibling->keys.front();
+        }
+        else
+        {
+            // The middle separator moves up; the keys and subtrees to its right move to the new node
+            separator = std::move(child->keys[mid]);
+            sibling->keys.assign(std::make_move_iterator(child->keys.begin() + mid + 1), std::make_move_iterator(child->keys.end()));
+            sibling->children.assign(child->children.begin() + mid + 1, child->children.end());
+            child->keys.resize(mid);
+            child->children.resize(mid + 1);
+        }
+        parent->keys.insert(parent->keys.begin() + i, std::move(separator));
+        parent->children.insert(parent->children.begin() + i + 1, sibling);
+    }
+
+    // Returns the posting list of x, adding x to the tree if it is not there yet
+    PostingList<Value> &findOrInsert(const Comparable &x)
+    {
+        if (root == nullptr)
+        {
+            root = new Node(true);
+        }
+        if (root->full())
+        {
+            Node *newRoot = new Node(false);
+            newRoot->children.push_back(root);
+            root = newRoot;
+            splitChild(root, 0);
+        }
+        Node *t = root;
+        while (!t->leaf)
+        {
+            size_t i = std::upper_bound(t->keys.begin(), t->keys.end(), x) - t->keys.begin();
+            if (t->children[i]->full())
+            {
+                splitChild(t, i);
+                if (!(x < t->keys[i])) // x belongs to the new right half
+                {
+                    ++i;
+                }
+            }
+            t = t->children[i];
+        }
+        size_t pos = std::lower_bound(t->keys.begin(), t->keys.end(), x) - t->keys.begin();
+        if (pos == t->keys.size() || x < t->keys[pos])
+        {
+            t->keys.insert(t->keys.begin() + pos, x);
+            t->postings.insert(t->postings.begin() + pos, PostingList<Value>());
+            size++;
+        }
+        return t->postings[pos];
+    }
+
+    // Leaf that would hold x
+    Node *findLeaf(const Comparable &x) const
+    {
+        Node *t = root;
+        while (t != nullptr && !t->leaf)
+        {
+            t = t->children[std::upper_bound(t->keys.begin(), t->keys.end(), x) - t->keys.begin()];
+        }
+        return t;
+    }
+
+    // Leftmost leaf, where in-order scans start
+    Node *firstLeaf() const
+    {
+        Node *t = root;
+        while (t != nullptr && !t->leaf)
+        {
+            t = t->children.front();
+        }
+        return t;
+    }
+
+    void makeEmpty(Node *t) // deletes the subtree
+    {
+        if (t != nullptr)
+        {
+            for (Node *child : t->children)
+            {
+                makeEmpty(child);
+            }
+            delete t;
+        }
+    }
+
+public:
+    // Default constructor
+    BPlusTree() : root{nullptr}, size{0} {}
+
+    // Copy constructor: re-inserts the keys of rhs in order
+    BPlusTree(const BPlusTree &rhs) : root{nullptr}, size{0}
+    {
+        merge(rhs);
+    }
+
+    // Move constructor: takes over the nodes of rhs, which is left empty
+    BPlusTree(BPlusTree &&rhs) noexcept : root{rhs.root}, size{rhs.size}
+    {
+        rhs.root = nullptr;
+        rhs.size = 0;
+    }
+
+    // Destructor
+    ~BPlusTree()
+    {
+        makeEmpty();
+    }
+
+    // Assignment operator
+    BPlusTree &operator=(const BPlusTree &rhs)
+    {
+        if (this != &rhs)
+        {
+            makeEmpty();
+            merge(rhs);
+        }
+        return *this;
+    }
+
+    // Move assignment operator
+    BPlusTree &operator=(BPlusTree &&rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            makeEmpty();
+            root = rhs.root;
+            size = rhs.size;
+            rhs.root = nullptr;
+            rhs.size = 0;
+        }
+        return *this;
+    }
+
+    // Check if a key is contained in the tree
+    bool contains(const Comparable &x) const
+    {
+        return find(x) != nullptr;
+    }
+
+    // Returns a pointer to the posting list stored for a key, or nullptr if the key is not in the tree
+    const PostingList<Value> *find(const Comparable &x) const
+    {
+        Node *t = findLeaf(x);
+        if (t == nullptr)
+        {
+            return nullptr;
+        }
+        auto itr = std::lower_bound(t->keys.begin(), t->keys.end(), x);
+        if (itr == t->keys.end() || x < *itr)
+        {
+            return nullptr;
+        }
+        return &t->postings[itr - t->keys.begin()];
+    }
+
+    // Check if the tree is empty
+    bool isEmpty() const
+    {
+        return size == 0;
+    }
+
+    // Get the number of keys in the tree
+    int getSize() const
+    {
+        return size;
+    }
+
+    // Make the tree empty
+    void makeEmpty()
+    {
+        makeEmpty(root);
+        root = nullptr;
+        size = 0;
+    }
+
+    // Insert a key-value pair into the tree
+    void insert(const Comparable &x, const Value &v)
+    {
+        findOrInsert(x).add(v);
+    }
+
+    // Insert a key-value pair with a frequency into the tree
+    void insert(const Comparable &x, const Value &v, const int &a)
+    {
+        findOrInsert(x).add(v, a);
+    }
+
+    // Add every key-value-count triple of another tree into this one
+    void merge(const BPlusTree &rhs)
+    {
+        merge(rhs, [](const Value &v)
+              { return v; });
+    }
+
+    // Add every key-value-count triple of another tree into this one, translating each value with remap
+    template <typename Remap>
+    void merge(const BPlusTree &rhs, Remap remap)
+    {
+        rhs.forEach([this, &remap](const Comparable &key, const PostingList<Value> &postings)
+                    {
+                        PostingList<Value> &target = findOrInsert(key);
+                        postings.forEach([&target, &remap](const Value &v, int freq)
+                                         { target.add(remap(v), freq); }); });
+    }
+
+    // Sort and compact the posting list of every key; lengths are the document lengths handed on to
+    // PostingList::finalize
+    void finalize(const int *lengths = nullptr, size_t lengthCount = 0)
+    {
+        for (Node *t = firstLeaf(); t != nullptr; t = t->next)
+        {
+            for (auto &postings : t->postings)
+            {
+                postings.finalize(lengths, lengthCount);
+            }
+        }
+    }
+
+    // Call visit(key, postings) for every key in ascending order
+    template <typename Visit>
+    void forEach(Visit visit) const
+    {
+        for (Node *t = firstLeaf(); t != nullptr; t = t->next)
+        {
+            for (size_t i = 0; i < t->keys.size(); i++)
+            {
+                visit(t->keys[i], t->postings[i]);
+            }
+        }
+    }
+
+    // Call visit(key, postings) in ascending order for every key with lo <= key < hi: one descent to the
+    // first key, then a walk along the leaves
+    template <typename Visit>
+    void forEachInRange(const Comparable &lo, const Comparable &hi, Visit visit) const
+    {
+        Node *t = findLeaf(lo);
+        if (t == nullptr)
+        {
+            return;
+        }
+        size_t i = std::lower_bound(t->keys.begin(), t->keys.end(), lo) - t->keys.begin();
+        for (; t != nullptr; t = t->next, i = 0)
+        {
+            for (; i < t->keys.size(); i++)
+            {
+                if (!(t->keys[i] < hi))
+                {
+                    return;
+                }
+                visit(t->keys[i], t->postings[i]);
+            }
+        }
+    }
+
+    // Print the tree in key order to an output stream
+    void printTree(std::ostream &out) const
+    {
+        forEach([&out](const Comparable &key, const PostingList<Value> &)
+                { out << key << std::endl; });
+    }
+};
+#endif
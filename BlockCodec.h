@@ -0,0 +1,492 @@
+#ifndef BLOCK_CODEC_H
+#define BLOCK_CODEC_H
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h> // SSE2 intrinsics for unpacking whole blocks
+#endif
+
+// Block compression of posting lists. A list of n ascending IDs and their frequencies is cut into blocks of
+// BLOCK_SIZE postings and stored as one run of bytes:
+//   Header[blockCount]  last ID of each block, where its payload starts and its score bound statistics
+//   payload             per block: the IDs, then the frequencies, each bit-packed at the block's own width
+// An ID is stored as its distance to the block's base, one past the last ID of the block before it (0 for the first
+// block), and a frequency as frequency - 1, so a block of frequencies that are all 1 takes no payload bits at all.
+// The headers hold every base, so a reader can skip whole blocks by looking at the headers alone, and since each
+// value sits at a fixed bit position, a single ID or frequency can be read without decoding the rest of its block.
+// Storing distances to the base rather than to the previous ID costs a few bits per ID but turns a search within a
+// block into a binary search over the packed values, which is what keeps sparse intersections cheap.
+//
+// Each header also records the largest frequency in its block and the length of the shortest document in it.
+// Every scorer in Scorer.h grows with the frequency and shrinks with the document length, so the two give an upper
+// bound on any score in the block, which lets ranked retrieval skip blocks that cannot reach the top k.
+//
+// Blocks of at least LANE_MIN values are packed in four interleaved lanes: value i goes to lane i % 4, each lane
+// is a stream of little-endian 32-bit words, and word w of lane l is stored as the (4w + l)-th word of the block.
+// One 128-bit load then holds the same word of every lane, so a block is unpacked four values at a time with
+// SSE2. A shorter last block is packed as a single stream, least significant bit first, so that short lists take
+// no more bytes than their values need; a last block long enough for lanes pays at most a word per lane for them,
+// and is unpacked as fast as a full one. Headers are in native byte order, like the index file.
+namespace BlockCodec
+{
+    // Postings per block; only the last block of a list can be shorter
+    const size_t BLOCK_SIZE = 128;
+
+    // Lanes of a full block and values per lane
+    const size_t LANES = 4;
+    const size_t LANE_LENGTH = BLOCK_SIZE / LANES;
+
+    // Fewest values of a block packed in lanes rather than as a single stream
+    const size_t LANE_MIN = 32;
+
+    // Per-block header. Read and written with memcpy, so a list can start at any byte
+    struct Header
+    {
+        uint32_t lastId;    // Largest ID in the block
+        uint32_t offset;    // Start of the block's payload, in bytes from the start of the list
+        uint32_t maxFreq;   // Largest frequency in the block
+        uint32_t minLength; // Fewest words of a document in the block, 0 if the lengths were not known
+        uint8_t idBits;     // Width of the packed IDs
+        uint8_t freqBits;   // Width of the packed frequencies
+    };
+
+    // Number of blocks of a list of n postings
+    inline size_t blockCount(size_t n)
+    {
+        return (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    }
+
+    // Number of postings in block b of a list of n postings
+    inline size_t blockLength(size_t n, size_t b)
+    {
+        return std::min(BLOCK_SIZE, n - b * BLOCK_SIZE);
+    }
+
+    // Bytes taken by n values packed at the given width as a single stream
+    inline size_t packedBytes(size_t n, unsigned bits)
+    {
+        return (n * bits + 7) / 8;
+    }
+
+    // Whether a block of n values is packed in lanes
+    inline bool laned(size_t n)
+    {
+        return n >= LANE_MIN;
+    }
+
+    // Bytes taken by a block of n values packed at the given width, in lanes or as a stream
+    inline size_t blockBytes(size_t n, unsigned bits)
+    {
+        if (laned(n))
+        {
+            const size_t laneLength = (n + LANES - 1) / LANES;
+            return LANES * 4 * ((laneLength * bits + 31) / 32);
+        }
+        return packedBytes(n, bits);
+    }
+
+    // Header of block b of a list
+    inline Header header(const uint8_t *list, size_t b)
+    {
+        Header h;
+        std::memcpy(&h, list + b * sizeof(Header), sizeof(Header));
+        return h;
+    }
+
+    // Last ID of block b of a list, without copying the rest of the header
+    inline uint32_t lastId(const uint8_t *list, size_t b)
+    {
+        uint32_t id;
+        std::memcpy(&id, list + b * sizeof(Header), sizeof(id));
+        return id;
+    }
+
+    // Smallest ID block b of a list can hold, which its IDs are stored relative to
+    inline uint32_t base(const uint8_t *list, size_t b)
+    {
+        return b == 0 ? 0 : lastId(list, b - 1) + 1;
+    }
+
+    // Score bound statistics of block b of a list
+    inline uint32_t maxFreq(const uint8_t *list, size_t b)
+    {
+        return header(list, b).maxFreq;
+    }
+    inline uint32_t minLength(const uint8_t *list, size_t b)
+    {
+        return header(list, b).minLength;
+    }
+
+    // Number of bits needed for the largest of n values
+    inline unsigned bitWidth(const uint32_t *values, size_t n)
+    {
+        uint32_t all = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            all |= values[i];
+        }
+        return all == 0 ? 0 : 32 - __builtin_clz(all);
+    }
+
+    // Mask of the low bits of a value
+    inline uint32_t lowBits(unsigned bits)
+    {
+        return uint32_t((uint64_t(1) << bits) - 1);
+    }
+
+    // Reads the little-endian 32-bit word at p
+    inline uint32_t load32(const uint8_t *p)
+    {
+        uint32_t word;
+        std::memcpy(&word, p, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap32(word);
+#endif
+        return word;
+    }
+
+    // Reads the little-endian 64-bit word at p
+    inline uint64_t load(const uint8_t *p)
+    {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        return word;
+    }
+
+    // Appends a block of n values at the given width to out, in lanes; the lanes of a shorter block end in zeros
+    inline void packLanes(const uint32_t *values, size_t n, unsigned bits, std::vector<uint8_t> &out)
+    {
+        const size_t start = out.size(), bytes = blockBytes(n, bits), laneWords = bytes / (4 * LANES);
+        out.resize(start + bytes, 0);
+        uint8_t *words = out.data() + start;
+        for (size_t lane = 0; lane < LANES; lane++)
+        {
+            for (size_t j = 0; j * LANES + lane < n; j++)
+            {
+                const size_t bit = j * bits, word = bit / 32;
+                const uint64_t shifted = uint64_t(values[j * LANES + lane]) << (bit % 32); // May spill into the next word
+                for (size_t w = word; w < word + 2 && w < laneWords; w++)
+                {
+                    const uint32_t part = uint32_t(shifted >> (32 * (w - word)));
+                    uint8_t *p = words + 4 * (w * LANES + lane);
+                    for (size_t k = 0; k < 4; k++)
+                    {
+                        p[k] |= uint8_t(part >> (8 * k));
+                    }
+                }
+            }
+        }
+    }
+
+    // Appends n values of the given width to out as a single stream
+    inline void pack(const uint32_t *values, size_t n, unsigned bits, std::vector<uint8_t> &out)
+    {
+        uint64_t pending = 0; // Bits not yet written, lowest first
+        unsigned filled = 0;  // Number of pending bits, always below 8 between values
+        for (size_t i = 0; i < n; i++)
+        {
+            pending |= uint64_t(values[i]) << filled;
+            filled += bits;
+            while (filled >= 8)
+            {
+                out.push_back(uint8_t(pending));
+                pending >>= 8;
+                filled -= 8;
+            }
+        }
+        if (filled > 0)
+        {
+            out.push_back(uint8_t(pending));
+        }
+    }
+
+#if defined(__SSE2__)
+    // Group j of a block of values of width BITS packed in lanes at words, masked to BITS bits and with offset added.
+    // Called from unrolled loops, so every shift and word index is a constant and the spill test disappears
+    template <unsigned BITS>
+    inline __m128i laneGroup(const __m128i *words, unsigned j, __m128i mask, __m128i offset)
+    {
+        const unsigned bit = j * BITS, shift = bit % 32;
+        __m128i v = _mm_srl_epi32(_mm_loadu_si128(words + bit / 32), _mm_cvtsi32_si128(int(shift)));
+        if (shift + BITS > 32)
+        {
+            __m128i next = _mm_loadu_si128(words + bit / 32 + 1);
+            v = _mm_or_si128(v, _mm_sll_epi32(next, _mm_cvtsi32_si128(int(32 - shift))));
+        }
+        return _mm_add_epi32(_mm_and_si128(v, mask), offset);
+    }
+#endif
+
+    // Unpacks a block of n values of width BITS packed in lanes at in and adds add to each of them. Writes exactly
+    // n values and reads no word past the lanes
+    template <unsigned BITS>
+    void unpackLanes(const uint8_t *in, size_t n, uint32_t add, uint32_t *out)
+    {
+        if constexpr (BITS == 0)
+        {
+            std::fill(out, out + n, add);
+        }
+        else
+        {
+            const size_t groups = n / LANES; // Groups of one value of every lane that the block fills
+            uint32_t rest[LANES];            // The values of the group a shorter block ends inside
+#if defined(__SSE2__)
+            const __m128i mask = _mm_set1_epi32(int(lowBits(BITS)));
+            const __m128i offset = _mm_set1_epi32(int(add));
+            const __m128i *words = reinterpret_cast<const __m128i *>(in);
+            if (n == BLOCK_SIZE) // Every block but the last, without the length tests
+            {
+#pragma GCC unroll 32
+                for (unsigned j = 0; j < LANE_LENGTH; j++)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + j * LANES), laneGroup<BITS>(words, j, mask, offset));
+                }
+                return;
+            }
+#pragma GCC unroll 32
+            for (unsigned j = 0; j < LANE_LENGTH; j++)
+            {
+                if (j > groups || (j == groups && n % LANES == 0))
+                {
+                    break;
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(j < groups ? out + j * LANES : rest), laneGroup<BITS>(words, j, mask, offset));
+            }
+#else
+            for (unsigned j = 0; j * LANES < n; j++)
+            {
+                const unsigned bit = j * BITS, shift = bit % 32;
+                for (unsigned lane = 0; lane < LANES; lane++)
+                {
+                    uint64_t v = load32(in + 4 * (bit / 32 * LANES + lane)) >> shift;
+                    if (shift + BITS > 32)
+                    {
+                        v |= uint64_t(load32(in + 4 * ((bit / 32 + 1) * LANES + lane))) << (32 - shift);
+                    }
+                    (j < groups ? out + j * LANES : rest)[lane] = (uint32_t(v) & lowBits(BITS)) + add;
+                }
+            }
+#endif
+            std::copy(rest, rest + n % LANES, out + groups * LANES);
+        }
+    }
+
+    // Reads one value of the given width at bit position bit of in, assembling it byte by byte so it never reads
+    // at or past byte available
+    inline uint32_t unpackTail(const uint8_t *in, size_t bit, unsigned bits, size_t available)
+    {
+        uint64_t word = 0;
+        for (size_t k = bit / 8; k < available && k < bit / 8 + 8; k++)
+        {
+            word |= uint64_t(in[k]) << (8 * (k - bit / 8));
+        }
+        return uint32_t((word >> (bit % 8)) & lowBits(bits));
+    }
+
+    // Unpacks n values of width BITS packed as a single stream at in and adds add to each of them; never reads at
+    // or past end. Eight values take exactly BITS bytes, so each group of eight is unpacked with constant offsets
+    template <unsigned BITS>
+    void unpackStream(const uint8_t *in, size_t n, uint32_t add, uint32_t *out, const uint8_t *end)
+    {
+        if constexpr (BITS == 0)
+        {
+            std::fill(out, out + n, add);
+        }
+        else
+        {
+            const size_t available = end - in;
+            size_t i = 0;
+            // Whole 64-bit loads while the group's last value has 8 bytes left to read
+            for (; i + 8 <= n && i / 8 * BITS + (7 * BITS) / 8 + 8 <= available; i += 8)
+            {
+                const uint8_t *group = in + i / 8 * BITS;
+                for (unsigned k = 0; k < 8; k++)
+                {
+                    out[i + k] = uint32_t((load(group + k * BITS / 8) >> (k * BITS % 8)) & lowBits(BITS)) + add;
+                }
+            }
+            // The last few values of a list
+            for (; i < n; i++)
+            {
+                out[i] = unpackTail(in, i * BITS, BITS, available) + add;
+            }
+        }
+    }
+
+    // unpackLanes and unpackStream for every width from 0 to 32
+    typedef void (*LaneUnpacker)(const uint8_t *, size_t, uint32_t, uint32_t *);
+    typedef void (*StreamUnpacker)(const uint8_t *, size_t, uint32_t, uint32_t *, const uint8_t *);
+    template <size_t... WIDTHS>
+    constexpr std::array<LaneUnpacker, sizeof...(WIDTHS)> laneUnpackers(std::index_sequence<WIDTHS...>)
+    {
+        return {{&unpackLanes<WIDTHS>...}};
+    }
+    template <size_t... WIDTHS>
+    constexpr std::array<StreamUnpacker, sizeof...(WIDTHS)> streamUnpackers(std::index_sequence<WIDTHS...>)
+    {
+        return {{&unpackStream<WIDTHS>...}};
+    }
+    inline constexpr std::array<LaneUnpacker, 33> LANE_UNPACKERS = laneUnpackers(std::make_index_sequence<33>());
+    inline constexpr std::array<StreamUnpacker, 33> STREAM_UNPACKERS = streamUnpackers(std::make_index_sequence<33>());
+
+    // Appends the n values of a block at the given width to out, in lanes if the block is long enough
+    inline void packBlock(const uint32_t *values, size_t n, unsigned bits, std::vector<uint8_t> &out)
+    {
+        if (laned(n))
+        {
+            packLanes(values, n, bits, out);
+        }
+        else
+        {
+            pack(values, n, bits, out);
+        }
+    }
+
+    // Unpacks the n values of a block packed by packBlock() at in and adds add to each of them; never reads at or
+    // past end
+    inline void unpackBlock(const uint8_t *in, size_t n, unsigned bits, uint32_t add, uint32_t *out, const uint8_t *end)
+    {
+        if (laned(n))
+        {
+            LANE_UNPACKERS[bits](in, n, add, out);
+        }
+        else
+        {
+            STREAM_UNPACKERS[bits](in, n, add, out, end);
+        }
+    }
+
+    // Reads the k-th of the n values of a block packed by packBlock() at in; never reads at or past end
+    inline uint32_t extract(const uint8_t *in, size_t n, size_t k, unsigned bits, const uint8_t *end)
+    {
+        if (laned(n))
+        {
+            const size_t bit = k / LANES * bits, shift = bit % 32, lane = k % LANES;
+            uint64_t v = load32(in + 4 * (bit / 32 * LANES + lane)) >> shift;
+            if (shift + bits > 32)
+            {
+                v |= uint64_t(load32(in + 4 * ((bit / 32 + 1) * LANES + lane))) << (32 - shift);
+            }
+            return uint32_t(v) & lowBits(bits);
+        }
+        const size_t bit = k * bits;
+        if (in + bit / 8 + 8 <= end)
+        {
+            return uint32_t((load(in + bit / 8) >> (bit % 8)) & lowBits(bits));
+        }
+        return unpackTail(in, bit, bits, end - in);
+    }
+
+    // Appends the encoding of a list of n ascending, distinct IDs and their frequencies to out. lengths holds the
+    // word count of the documents below lengthCount and feeds each block's minLength; documents it does not cover
+    // count as length 0, which only loosens the bound
+    inline void encode(const uint32_t *ids, const int *freqs, size_t n, std::vector<uint8_t> &out,
+                       const int *lengths = nullptr, size_t lengthCount = 0)
+    {
+        const size_t start = out.size();
+        const size_t blocks = blockCount(n);
+        out.resize(start + blocks * sizeof(Header)); // Headers are filled in as their blocks are written
+        uint32_t offsets[BLOCK_SIZE], counts[BLOCK_SIZE];
+        uint32_t blockBase = 0;
+        for (size_t b = 0; b < blocks; b++)
+        {
+            const size_t first = b * BLOCK_SIZE, length = blockLength(n, b);
+            Header h;
+            std::memset(&h, 0, sizeof(h)); // Padding bytes end up in the file too
+            h.minLength = UINT32_MAX;
+            for (size_t i = 0; i < length; i++)
+            {
+                offsets[i] = ids[first + i] - blockBase;
+                counts[i] = uint32_t(freqs[first + i]) - 1;
+                h.maxFreq = std::max(h.maxFreq, uint32_t(freqs[first + i]));
+                const uint32_t docLength = ids[first + i] < lengthCount ? uint32_t(std::max(lengths[ids[first + i]], 0)) : 0;
+                h.minLength = std::min(h.minLength, docLength);
+            }
+            h.lastId = ids[first + length - 1];
+            h.offset = uint32_t(out.size() - start);
+            h.idBits = bitWidth(offsets, length);
+            h.freqBits = bitWidth(counts, length);
+            packBlock(offsets, length, h.idBits, out);
+            packBlock(counts, length, h.freqBits, out);
+            std::memcpy(out.data() + start + b * sizeof(Header), &h, sizeof(h));
+            blockBase = h.lastId + 1;
+        }
+    }
+
+    // Decodes the IDs of block b of an encoded list of n postings that takes size bytes; returns their number
+    inline size_t decodeIds(const uint8_t *list, size_t size, size_t n, size_t b, uint32_t *ids)
+    {
+        const Header h = header(list, b);
+        const size_t length = blockLength(n, b);
+        unpackBlock(list + h.offset, length, h.idBits, base(list, b), ids, list + size);
+        return length;
+    }
+
+    // Decodes the frequencies of block b of an encoded list of n postings that takes size bytes
+    inline size_t decodeFreqs(const uint8_t *list, size_t size, size_t n, size_t b, int *freqs)
+    {
+        const Header h = header(list, b);
+        const size_t length = blockLength(n, b);
+        uint32_t *counts = reinterpret_cast<uint32_t *>(freqs); // int and uint32_t may alias
+        unpackBlock(list + h.offset + blockBytes(length, h.idBits), length, h.freqBits, 1, counts, list + size);
+        return length;
+    }
+
+    // A block of an encoded list opened for reading single values in place
+    struct Block
+    {
+        const uint8_t *ids;    // Packed IDs
+        const uint8_t *counts; // Packed frequencies
+        const uint8_t *end;    // End of the list, which packed values are never read past
+        uint32_t base;         // Value added to every packed ID
+        size_t length;         // Number of postings
+        unsigned idBits, freqBits;
+
+        // ID and frequency of the k-th posting
+        uint32_t id(size_t k) const { return base + extract(ids, length, k, idBits, end); }
+        int freq(size_t k) const { return int(extract(counts, length, k, freqBits, end) + 1); }
+
+        // First position at or after from whose ID is not less than target (length if there is none). Binary
+        // searches the packed IDs
+        size_t seek(uint32_t target, size_t from) const
+        {
+            if (target <= base)
+            {
+                return from;
+            }
+            const uint32_t offset = target - base; // Compared with the packed values directly
+            size_t lo = from, hi = length;
+            while (lo < hi)
+            {
+                size_t mid = lo + (hi - lo) / 2;
+                if (extract(ids, length, mid, idBits, end) < offset)
+                {
+                    lo = mid + 1;
+                }
+                else
+                {
+                    hi = mid;
+                }
+            }
+            return lo;
+        }
+    };
+
+    // Opens block b of an encoded list of n postings that takes size bytes
+    inline Block block(const uint8_t *list, size_t size, size_t n, size_t b)
+    {
+        const Header h = header(list, b);
+        const size_t length = blockLength(n, b);
+        const uint8_t *ids = list + h.offset;
+        return Block{ids, ids + blockBytes(length, h.idBits), list + size, base(list, b), length, h.idBits, h.freqBits};
+    }
+}
+#endif
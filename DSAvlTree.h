@@ -5,10 +5,11 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>
-#include <map>
+#include "PostingList.h"
+#include "NodePool.h"
 
-// Template class for a node in an AVL tree
-template <typename Comparable, typename Value>
+// Template class for a node in an AVL tree; nodes are allocated through the Alloc policy (see NodePool.h)
+template <typename Comparable, typename Value, template <typename> class Alloc = NodePool>
 class DSAvlTree
 {
 private:
@@ -19,7 +20,7 @@ private:
         DSAvlNode *left;              // Pointer to the left child
         DSAvlNode *right;             // Pointer to the right child
         int height;                   // Height of the node
-        std::map<Value, int> mapVals; // Map to store associated values and their counts
+        PostingList<Value> postings;  // Associated values and their counts, stored contiguously
 
         // Constructor for node with key, left and right children, and height
         DSAvlNode(const Comparable &theKey, DSAvlNode *lt, DSAvlNode *rt, int h)
@@ -29,23 +30,31 @@ private:
         DSAvlNode(const Comparable &theKey, Value v, DSAvlNode *lt, DSAvlNode *rt, int h)
             : key{theKey}, left{lt}, right{rt}, height{h}
         {
-            mapVals.emplace(v, 1);
+            postings.add(v);
         }
     };
 
-    DSAvlNode *root; // Root node of the AVL tree
-    int size;        // Size of the AVL tree (number of nodes)
+    DSAvlNode *root;       // Root node of the AVL tree
+    int size;              // Size of the AVL tree (number of nodes)
+    Alloc<DSAvlNode> pool; // Allocates the nodes
 
 public:
     // Default constructor
     DSAvlTree() : root{nullptr}, size{0} {}
 
     // Copy constructor
-    DSAvlTree(const DSAvlTree &rhs) : root{nullptr}
+    DSAvlTree(const DSAvlTree &rhs) : root{nullptr}, size{rhs.size}
     {
         root = clone(rhs.root);
     }
 
+    // Move constructor: takes over the nodes of rhs, which is left empty
+    DSAvlTree(DSAvlTree &&rhs) noexcept : root{rhs.root}, size{rhs.size}, pool{std::move(rhs.pool)}
+    {
+        rhs.root = nullptr;
+        rhs.size = 0;
+    }
+
     // Destructor
     ~DSAvlTree()
     {
@@ -57,13 +66,35 @@ public:
     {
         makeEmpty();
         root = clone(rhs.root);
+        size = rhs.size;
+        return *this;
+    }
+
+    // Move assignment operator
+    DSAvlTree &operator=(DSAvlTree &&rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            makeEmpty();
+            root = rhs.root;
+            size = rhs.size;
+            pool = std::move(rhs.pool);
+            rhs.root = nullptr;
+            rhs.size = 0;
+        }
         return *this;
     }
 
     // Check if a key is contained in the tree
-    std::map<Value, int> contains(const Comparable &x) const
+    bool contains(const Comparable &x) const
     {
-        return contains(x, root);
+        return find(x, root) != nullptr;
+    }
+
+    // Returns a pointer to the posting list stored for a key, or nullptr if the key is not in the tree
+    const PostingList<Value> *find(const Comparable &x) const
+    {
+        return find(x, root);
     }
 
     // Check if the tree is empty
@@ -76,6 +107,7 @@ public:
     void makeEmpty()
     {
         makeEmpty(root);
+        pool.release(); // Every node is gone, so the pool's memory goes back in one go
         root = nullptr;
         size = 0;
     }
@@ -92,6 +124,34 @@ public:
         insert(x, v, a, root);
     }
 
+    // Add every key-value-count triple of another tree into this one
+    void merge(const DSAvlTree &rhs)
+    {
+        merge(rhs, [](const Value &v)
+              { return v; });
+    }
+
+    // Add every key-value-count triple of another tree into this one, translating each value with remap
+    template <typename Remap>
+    void merge(const DSAvlTree &rhs, Remap remap)
+    {
+        merge(rhs.root, remap);
+    }
+
+    // Finalize every posting list once insertion is done (sorts and compacts them); lengths are the document
+    // lengths handed on to PostingList::finalize
+    void finalize(const int *lengths = nullptr, size_t lengthCount = 0)
+    {
+        finalize(root, lengths, lengthCount);
+    }
+
+    // Call visit(key, postings) for every node, in ascending key order
+    template <typename Visit>
+    void forEach(Visit visit) const
+    {
+        forEach(root, visit);
+    }
+
     // Remove a key from the tree
     void remove(const Comparable &x)
     {
@@ -99,7 +159,7 @@ public:
     }
 
     // Get the size of the tree
-    int getSize()
+    int getSize() const
     {
         return size;
     }
@@ -119,7 +179,7 @@ private:
         // Insert logic with balancing
         if (t == nullptr)
         {
-            t = new DSAvlNode{x, v, nullptr, nullptr, 0}; // insert new node and increment size
+            t = pool.create(x, v, nullptr, nullptr, 0); // insert new node and increment size
             size++;
         }
         else if (x < t->key)
@@ -132,14 +192,7 @@ private:
         }
         else
         {
-            if (t->mapVals.find(v) == t->mapVals.end()) // if it's not in the tree, set frequency to 1
-            {
-                t->mapVals[v] = 1;
-            }
-            else
-            {
-                t->mapVals[v] += 1; // otherwise, increment frequency
-            }
+            t->postings.add(v); // append v with frequency 1, or increment its frequency
             return;
         }
         balance(t); // balance the tree
@@ -151,8 +204,8 @@ private:
         // Insert logic with count and balancing
         if (t == nullptr)
         {
-            t = new DSAvlNode{x, v, nullptr, nullptr, 0}; // add a new node with a given frequency and increment size
-            t->mapVals[v] = a;
+            t = pool.create(x, nullptr, nullptr, 0); // add a new node with a given frequency and increment size
+            t->postings.add(v, a);
             size++;
         }
         else if (x < t->key)
@@ -165,19 +218,48 @@ private:
         }
         else
         {
-            if (t->mapVals.find(v) == t->mapVals.end()) // if not in there, set the frequency equal to a
-            {
-                t->mapVals[v] = a;
-            }
-            else
-            {
-                t->mapVals[v] += a; // otherwise just add a
-            }
+            t->postings.add(v, a); // append v with frequency a, or add a to its frequency
             return;
         }
         balance(t); // balance the tree
     }
 
+    // Insert all entries of another subtree, adding frequencies for keys that already exist
+    template <typename Remap>
+    void merge(DSAvlNode *t, Remap &remap)
+    {
+        if (t != nullptr)
+        {
+            t->postings.forEach([this, t, &remap](const Value &v, int freq)
+                                { insert(t->key, remap(v), freq, root); });
+            merge(t->left, remap);
+            merge(t->right, remap);
+        }
+    }
+
+    // In-order traversal of a subtree
+    template <typename Visit>
+    void forEach(DSAvlNode *t, Visit &visit) const
+    {
+        if (t != nullptr)
+        {
+            forEach(t->left, visit);
+            visit(t->key, t->postings);
+            forEach(t->right, visit);
+        }
+    }
+
+    // Finalize the posting lists of a subtree
+    void finalize(DSAvlNode *t, const int *lengths, size_t lengthCount)
+    {
+        if (t != nullptr)
+        {
+            t->postings.finalize(lengths, lengthCount);
+            finalize(t->left, lengths, lengthCount);
+            finalize(t->right, lengths, lengthCount);
+        }
+    }
+
     // Remove a key from a subtree
     void remove(const Comparable &x, DSAvlNode *&t) // removes x from a subtree, t is the node that roots the subtree
     {
@@ -205,11 +287,11 @@ private:
             {
                 DSAvlNode *tCopy = t;
                 t = t->left;
-                delete tCopy;
+                pool.destroy(tCopy);
             }
             else // otherwise
             {
-                delete t;
+                pool.destroy(t);
                 t = nullptr;
                 size--;
                 return;
@@ -231,7 +313,7 @@ private:
         {
             // found left most node in subtree
             Comparable valueToReturn = t->key;
-            delete t;
+            pool.destroy(t);
             t = nullptr;
 
             return valueToReturn;
@@ -246,25 +328,26 @@ private:
     }
 
     // Check if a key is contained in a subtree
-    std::map<Value, int> contains(const Comparable &x, DSAvlNode *t) const // true/false if x is found in the tree
+    // Find the posting list of a key in a subtree
+    const PostingList<Value> *find(const Comparable &x, DSAvlNode *t) const // postings of x, nullptr if x is not in the tree
     {
-        // Logic to check if a key is contained
-        if (t == nullptr)
-        {
-            return std::map<Value, int>(); // returns an empty vector
-        }
-        else if (x < t->key)
-        {
-            return contains(x, t->left); // call recursively
-        }
-        else if (t->key < x)
+        // Walk down iteratively; the list is returned in place rather than copied
+        while (t != nullptr)
         {
-            return contains(x, t->right); // call recursively
-        }
-        else
-        {
-            return t->mapVals;
+            if (x < t->key)
+            {
+                t = t->left;
+            }
+            else if (t->key < x)
+            {
+                t = t->right;
+            }
+            else
+            {
+                return &t->postings;
+            }
         }
+        return nullptr;
     }
 
     // Make a subtree empty
@@ -275,19 +358,19 @@ private:
         {
             makeEmpty(t->left);
             makeEmpty(t->right);
-            delete t;
+            pool.destroy(t);
             t = nullptr;
         }
     }
 
-    DSAvlNode *clone(DSAvlNode *t) const
+    DSAvlNode *clone(DSAvlNode *t)
     {
         // clones the subtree
         if (t == nullptr)
         {
             return nullptr;
         }
-        DSAvlNode *newNode = new DSAvlNode(*t);
+        DSAvlNode *newNode = pool.create(*t);
         newNode->left = clone(t->left);
         newNode->right = clone(t->right);
         newNode->height = t->height;
@@ -360,10 +443,7 @@ private:
         if (t != nullptr)
         {
             out << t->key << ":";
-            for (const auto &itr : t->mapVals)
-            {
-                out << itr.first << "," << itr.second << ";";
-            }
+            t->postings.print(out);
             out << std::endl;
             printTree(out, t->left);
             printTree(out, t->right);
@@ -4,9 +4,11 @@
 
 // Including necessary header files
 #include "IndexHandler.h"             // Include the IndexHandler header for indexing functionality
-#include "rapidjson/istreamwrapper.h" // Include RapidJSON's istreamwrapper for handling JSON streams
-#include "rapidjson/document.h"       // Include RapidJSON's document header for parsing JSON documents
+#include "DocumentReader.h"           // Include the DocumentReader header for reading the fields of JSON documents
 #include "porter2_stemmer.h"          // Include the Porter Stemmer header for word stemming functionality
+#include "StemCache.h"                // Include the StemCache header for memoized stemming
+#include "Tokenizer.h"                // Include the Tokenizer header for splitting document text into words
+#include "StopWords.h"                // Include the StopWords header for the words left out of the index
 #include <string>                     // Standard library for string handling
 #include <vector>                     // Standard library for vector data structure
 #include <map>                        // Standard library for map data structure
@@ -17,7 +19,11 @@
 #include <filesystem>                 // Standard library for filesystem operations
 #include <dirent.h>                   // Include for directory traversing
 #include <algorithm>                  // Standard library for various algorithms
+#include <cstring>                    // Standard library for C string functions
 #include <set>                        // Standard library for set data structure
+#include <thread>                     // Standard library for worker threads
+#include <mutex>                      // Standard library for mutual exclusion
+#include <atomic>                     // Standard library for atomic counters
 
 // Class definition for DocumentParser
 class DocumentParser
@@ -26,6 +32,10 @@ private:
     // Private member variables
     IndexHandler ih;                 // An instance of IndexHandler for handling indexing operations
     std::vector<std::string> titles; // A vector to store document titles
+    StopWords stopWords;             // Words that are not indexed
+
+    // Parses a JSON document and indexes its content into the given index
+    void parseDocument(const std::string &jsonContent, IndexHandler &index);
 
 public:
     // Public member functions
@@ -33,21 +43,30 @@ public:
     // Parses a JSON document and indexes its content
     void parseDocument(const std::string &jsonContent);
 
+    // Replaces the built-in stopword list with the words of a file; returns false if it cannot be read
+    bool loadStopWords(const std::string &path);
+
+    // Records word positions in the index from now on, so it can answer phrase queries
+    void enablePositions() { ih.enablePositions(); };
+
     // Prints the content of a JSON document
     void printDocument(const std::string &jsonContent);
 
-    // Sets the index handler for the parser
-    void setIndex(IndexHandler ih);
+    // The index built so far, by reference
+    const IndexHandler &getIndex() const { return ih; };
 
-    // Retrieves the index handler used by the parser
-    IndexHandler getIndex();
+    // Hands the built index over as a shared, read-only snapshot (moved, not copied); the parser starts a new one
+    std::shared_ptr<const IndexHandler> releaseIndex();
 
-    // Traverses a given directory and processes subdirectories
-    void traverseSubdirectory(const std::string &directoryPath);
+    // Traverses a given directory and processes subdirectories, parsing files on the given number of threads
+    void traverseSubdirectory(const std::string &directoryPath, int threads = 1);
 
     // Prints information extracted from a JSON document
     void printInfo(const std::string &jsonContent);
 
+    // Prints the same information for a document of an index, from its document table
+    void printInfo(const IndexHandler &index, DocId id);
+
     // Retrieves the title of a document given its index
     std::string getTitle(int num) { return titles[num]; };
 };
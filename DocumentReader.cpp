@@ -0,0 +1,223 @@
+#include "DocumentReader.h"
+#include <fstream>
+#include <iostream>
+
+// Reads the whole file into the reused buffer and runs the SAX parser over it in place
+bool DocumentReader::read(const std::string &path)
+{
+    clear();
+    std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+    if (!ifs.is_open())
+    {
+        std::cerr << "Could not open file for reading: " << path << std::endl;
+        return false;
+    }
+    std::streamsize size = ifs.tellg();
+    ifs.seekg(0);
+    buffer.resize(size < 0 ? 1 : size + 1);
+    if (size < 0 || !ifs.read(buffer.data(), size))
+    {
+        std::cerr << "Could not open file for reading: " << path << std::endl;
+        return false;
+    }
+    buffer[size] = '\0'; // In-situ parsing needs a terminated buffer
+
+    rapidjson::InsituStringStream stream(buffer.data());
+    rapidjson::Reader parser;
+    Handler handler(*this);
+    parser.Parse<rapidjson::kParseInsituFlag>(stream, handler);
+    if (parser.HasParseError())
+    {
+        std::cerr << "JSON parse error: " << parser.GetParseErrorCode() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void DocumentReader::clear()
+{
+    title = text = published = site = persons = orgs = std::string_view();
+    personNames.clear();
+    orgNames.clear();
+    hasTitle = hasText = hasPublished = hasSite = hasPersons = hasOrgs = false;
+    contexts.clear();
+    field = NONE;
+    copies.clear();
+}
+
+std::string_view DocumentReader::keep(const char *str, rapidjson::SizeType length, bool copy)
+{
+    if (!copy)
+    {
+        return std::string_view(str, length); // Points into the buffer
+    }
+    copies.emplace_back(str, length);
+    return copies.back();
+}
+
+// Numbers, booleans and nulls are never kept
+bool DocumentReader::Handler::Default()
+{
+    reader.field = NONE;
+    return true;
+}
+
+bool DocumentReader::Handler::String(const char *str, rapidjson::SizeType length, bool copy)
+{
+    switch (reader.field)
+    {
+    case TITLE:
+        reader.title = reader.keep(str, length, copy);
+        reader.hasTitle = true;
+        break;
+    case TEXT:
+        reader.text = reader.keep(str, length, copy);
+        reader.hasText = true;
+        break;
+    case PUBLISHED:
+        reader.published = reader.keep(str, length, copy);
+        reader.hasPublished = true;
+        break;
+    case SITE:
+        reader.site = reader.keep(str, length, copy);
+        reader.hasSite = true;
+        break;
+    case PERSONS_TEXT:
+        reader.persons = reader.keep(str, length, copy);
+        reader.hasPersons = true;
+        break;
+    case ORGS_TEXT:
+        reader.orgs = reader.keep(str, length, copy);
+        reader.hasOrgs = true;
+        break;
+    case NAME:
+        (reader.contexts.back() == PERSON ? reader.personNames : reader.orgNames).push_back(reader.keep(str, length, copy));
+        break;
+    default:
+        break;
+    }
+    reader.field = NONE;
+    return true;
+}
+
+// Remembers which kept field, if any, the value after this key belongs to
+bool DocumentReader::Handler::Key(const char *str, rapidjson::SizeType length, bool)
+{
+    std::string_view key(str, length);
+    reader.field = NONE;
+    switch (reader.contexts.back())
+    {
+    case ROOT:
+        if (key == "title")
+        {
+            reader.field = TITLE;
+        }
+        else if (key == "text")
+        {
+            reader.field = TEXT;
+        }
+        else if (key == "published")
+        {
+            reader.field = PUBLISHED;
+        }
+        else if (key == "thread")
+        {
+            reader.field = THREAD_OBJECT;
+        }
+        else if (key == "entities")
+        {
+            reader.field = ENTITIES_OBJECT;
+        }
+        else if (key == "persons")
+        {
+            reader.field = PERSONS_TEXT;
+        }
+        else if (key == "organizations")
+        {
+            reader.field = ORGS_TEXT;
+        }
+        break;
+    case THREAD:
+        if (key == "site")
+        {
+            reader.field = SITE;
+        }
+        break;
+    case ENTITIES:
+        if (key == "persons")
+        {
+            reader.field = PERSONS_ARRAY;
+        }
+        else if (key == "organizations")
+        {
+            reader.field = ORGS_ARRAY;
+        }
+        break;
+    case PERSON:
+    case ORG:
+        if (key == "name")
+        {
+            reader.field = NAME;
+        }
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+bool DocumentReader::Handler::StartObject()
+{
+    Context context = SKIPPED;
+    if (reader.contexts.empty())
+    {
+        context = ROOT;
+    }
+    else if (reader.field == THREAD_OBJECT)
+    {
+        context = THREAD;
+    }
+    else if (reader.field == ENTITIES_OBJECT)
+    {
+        context = ENTITIES;
+    }
+    else if (reader.contexts.back() == PERSONS)
+    {
+        context = PERSON;
+    }
+    else if (reader.contexts.back() == ORGS)
+    {
+        context = ORG;
+    }
+    reader.contexts.push_back(context);
+    reader.field = NONE;
+    return true;
+}
+
+bool DocumentReader::Handler::EndObject(rapidjson::SizeType)
+{
+    reader.contexts.pop_back();
+    return true;
+}
+
+bool DocumentReader::Handler::StartArray()
+{
+    Context context = SKIPPED;
+    if (reader.field == PERSONS_ARRAY)
+    {
+        context = PERSONS;
+    }
+    else if (reader.field == ORGS_ARRAY)
+    {
+        context = ORGS;
+    }
+    reader.contexts.push_back(context);
+    reader.field = NONE;
+    return true;
+}
+
+bool DocumentReader::Handler::EndArray(rapidjson::SizeType)
+{
+    reader.contexts.pop_back();
+    return true;
+}
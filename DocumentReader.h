@@ -0,0 +1,95 @@
+#ifndef DOCUMENT_READER_H
+#define DOCUMENT_READER_H
+
+// Including necessary header files
+#include "rapidjson/reader.h" // Include RapidJSON's SAX reader
+#include <deque>              // Standard library for string copies that never move
+#include <string>             // Standard library for string handling
+#include <string_view>        // Standard library for non-owning string views
+#include <vector>             // Standard library for vector data structure
+
+// Class definition for DocumentReader: reads the fields the search engine uses out of a news JSON file.
+//
+// The whole file is read into one buffer, kept from document to document, and parsed in situ with RapidJSON's
+// SAX reader, so no DOM is built: only the fields below are kept, as views into the buffer, and every other
+// value is skipped as soon as it is parsed. The views stay valid until the next call to read().
+class DocumentReader
+{
+public:
+    std::string_view title;     // Top-level "title"
+    std::string_view text;      // Top-level "text"
+    std::string_view published; // Top-level "published"
+    std::string_view site;      // "thread": {"site"}
+    std::string_view persons;   // Top-level "persons", if the document has it as a string
+    std::string_view orgs;      // Top-level "organizations", if the document has it as a string
+
+    std::vector<std::string_view> personNames; // "entities": {"persons": [{"name"}, ...]}
+    std::vector<std::string_view> orgNames;    // "entities": {"organizations": [{"name"}, ...]}
+
+    bool hasTitle = false;     // Whether the fields above were present as strings
+    bool hasText = false;
+    bool hasPublished = false;
+    bool hasSite = false;
+    bool hasPersons = false;
+    bool hasOrgs = false;
+
+    // Reads and parses the file at path; prints the reason and returns false if it cannot be opened or parsed
+    bool read(const std::string &path);
+
+private:
+    // Where the parser currently is, as far as the kept fields are concerned
+    enum Context
+    {
+        ROOT,     // The top-level object
+        THREAD,   // "thread"
+        ENTITIES, // "entities"
+        PERSONS,  // "entities"."persons"
+        ORGS,     // "entities"."organizations"
+        PERSON,   // An object in "persons"
+        ORG,      // An object in "organizations"
+        SKIPPED   // Anything else
+    };
+
+    // The field the next value belongs to, set by the key before it
+    enum Field
+    {
+        NONE,
+        TITLE,
+        TEXT,
+        PUBLISHED,
+        SITE,
+        PERSONS_TEXT,
+        ORGS_TEXT,
+        THREAD_OBJECT,
+        ENTITIES_OBJECT,
+        PERSONS_ARRAY,
+        ORGS_ARRAY,
+        NAME
+    };
+
+    // SAX callbacks
+    struct Handler : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Handler>
+    {
+        DocumentReader &reader;
+        Handler(DocumentReader &r) : reader(r) {}
+        bool Default();
+        bool String(const char *, rapidjson::SizeType, bool);
+        bool Key(const char *, rapidjson::SizeType, bool);
+        bool StartObject();
+        bool EndObject(rapidjson::SizeType);
+        bool StartArray();
+        bool EndArray(rapidjson::SizeType);
+    };
+
+    std::vector<char> buffer;       // The file, NUL-terminated; strings are unescaped in place
+    std::vector<Context> contexts;  // Open objects and arrays, innermost last
+    Field field = NONE;             // Field of the next value
+    std::deque<std::string> copies; // Strings the parser could not leave in the buffer
+
+    // Empties every field before a new document
+    void clear();
+
+    // A view of a string value, copied first if the parser only lends it for the duration of the callback
+    std::string_view keep(const char *, rapidjson::SizeType, bool copy);
+};
+#endif
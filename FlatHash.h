@@ -0,0 +1,238 @@
+#ifndef FLATHASH_H
+#define FLATHASH_H
+#include "PostingList.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h> // SSE2 intrinsics for probing a whole group of control bytes at once
+#endif
+
+// Open-addressing hash table in the style of a Swiss table, with the same interface as Hash.
+//
+// Keys and their posting lists live in one flat slot array, split into groups of 16 slots. A parallel array
+// holds one control byte per slot: EMPTY, or the low 7 bits of the key's hash. A lookup hashes the key once,
+// picks a starting group from the high bits, and compares all 16 control bytes of the group with the 7-bit
+// tag in one SSE2 instruction. Only slots whose tag matches are compared by key, so a lookup usually touches
+// the group's control bytes and one slot. Groups are probed in triangular order until one contains an empty
+// slot. Keys are never removed, so the first empty slot on a key's probe sequence ends the search.
+template <typename Comparable, typename Value>
+class FlatHash
+{
+private:
+    static constexpr size_t GROUP = 16;          // Slots per group (one SSE2 register of control bytes)
+    static constexpr int8_t EMPTY = -128;        // Control byte of an unused slot; tags are 0..127
+    static constexpr size_t MIN_CAPACITY = GROUP; // A new table is a single group
+
+    // A key and its posting list
+    struct Slot
+    {
+        Comparable comp;
+        PostingList<Value> postings;
+    };
+
+    std::vector<int8_t> control; // One control byte per slot
+    std::vector<Slot> slots;     // Keys and posting lists, capacity of them
+    size_t capacity;             // Number of slots, a power of two and a multiple of GROUP
+    size_t size;                 // Number of keys in the table
+
+    // Bit i of the result is set if control byte i of the group starting at first equals tag
+    static uint32_t matchGroup(const int8_t *first, int8_t tag)
+    {
+#if defined(__SSE2__)
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP; i++)
+        {
+            if (first[i] == tag)
+            {
+                mask |= 1u << i;
+            }
+        }
+        return mask;
+#endif
+    }
+
+    // Index of the lowest set bit of a non-zero mask
+    static size_t lowestBit(uint32_t mask)
+    {
+        return __builtin_ctz(mask);
+    }
+
+    // Splits a key's hash into the 7-bit tag kept in the control byte and the group the probe starts at
+    void hashKey(const Comparable &comp, int8_t &tag, size_t &group) const
+    {
+        size_t h = std::hash<Comparable>{}(comp);
+        tag = h & 0x7F;
+        group = (h >> 7) & (capacity / GROUP - 1);
+    }
+
+    // Returns the slot holding comp, or creates one for it
+    Slot &findOrInsert(const Comparable &comp)
+    {
+        if ((size + 1) * 8 > capacity * 7) // Keep at least 1/8 of the slots empty so probes stay short
+        {
+            rehash(capacity * 2);
+        }
+        int8_t tag;
+        size_t group;
+        hashKey(comp, tag, group);
+        for (size_t step = 1;; step++)
+        {
+            const int8_t *first = control.data() + group * GROUP;
+            for (uint32_t mask = matchGroup(first, tag); mask != 0; mask &= mask - 1)
+            {
+                Slot &slot = slots[group * GROUP + lowestBit(mask)];
+                if (slot.comp == comp)
+                {
+                    return slot;
+                }
+            }
+            uint32_t empty = matchGroup(first, EMPTY);
+            if (empty != 0) // The key is not in the table: it would have been placed here or earlier
+            {
+                size_t index = group * GROUP + lowestBit(empty);
+                control[index] = tag;
+                slots[index].comp = comp;
+                size++;
+                return slots[index];
+            }
+            group = (group + step) & (capacity / GROUP - 1); // Triangular probing visits every group
+        }
+    }
+
+    // Moves every key into a table with newCapacity slots
+    void rehash(size_t newCapacity)
+    {
+        std::vector<int8_t> oldControl = std::move(control);
+        std::vector<Slot> oldSlots = std::move(slots);
+        control.assign(newCapacity, EMPTY);
+        slots.clear();
+        slots.resize(newCapacity);
+        capacity = newCapacity;
+        size = 0;
+        for (size_t i = 0; i < oldSlots.size(); i++)
+        {
+            if (oldControl[i] != EMPTY)
+            {
+                findOrInsert(oldSlots[i].comp).postings = std::move(oldSlots[i].postings);
+            }
+        }
+    }
+
+public:
+    FlatHash() : control(MIN_CAPACITY, EMPTY), slots(MIN_CAPACITY), capacity{MIN_CAPACITY}, size{0} {}
+
+    // Get the current size of the hash table
+    int getSize() const
+    {
+        return size;
+    }
+
+    // Removes every key and shrinks the table back to its initial capacity
+    void clear()
+    {
+        control.assign(MIN_CAPACITY, EMPTY);
+        slots.clear();
+        slots.resize(MIN_CAPACITY);
+        capacity = MIN_CAPACITY;
+        size = 0;
+    }
+
+    // Insert a key-value pair into the hash table
+    void insert(const Comparable &comp, const Value &val)
+    {
+        findOrInsert(comp).postings.add(val);
+    }
+
+    // Insert a key-value pair with a frequency into the hash table
+    void insert(const Comparable &comp, const Value &val, int freq)
+    {
+        findOrInsert(comp).postings.add(val, freq);
+    }
+
+    // Returns a pointer to the posting list stored for a key, or nullptr if the key is not in the table
+    const PostingList<Value> *find(const Comparable &comp) const
+    {
+        int8_t tag;
+        size_t group;
+        hashKey(comp, tag, group);
+        for (size_t step = 1;; step++)
+        {
+            const int8_t *first = control.data() + group * GROUP;
+            for (uint32_t mask = matchGroup(first, tag); mask != 0; mask &= mask - 1)
+            {
+                const Slot &slot = slots[group * GROUP + lowestBit(mask)];
+                if (slot.comp == comp)
+                {
+                    return &slot.postings;
+                }
+            }
+            if (matchGroup(first, EMPTY) != 0)
+            {
+                return nullptr;
+            }
+            group = (group + step) & (capacity / GROUP - 1);
+        }
+    }
+
+    // Add every key-value-count triple of another hash table into this one
+    void merge(const FlatHash &rhs)
+    {
+        merge(rhs, [](const Value &v)
+              { return v; });
+    }
+
+    // Add every key-value-count triple of another hash table into this one, translating each value with remap
+    template <typename Remap>
+    void merge(const FlatHash &rhs, Remap remap)
+    {
+        rhs.forEach([this, &remap](const Comparable &comp, const PostingList<Value> &postings)
+                    {
+                        PostingList<Value> &target = findOrInsert(comp).postings;
+                        postings.forEach([&target, &remap](const Value &v, int freq)
+                                         { target.add(remap(v), freq); }); });
+    }
+
+    // Call visit(key, postings) for every key in the table, in slot order
+    template <typename Visit>
+    void forEach(Visit visit) const
+    {
+        for (size_t i = 0; i < capacity; i++)
+        {
+            if (control[i] != EMPTY)
+            {
+                visit(slots[i].comp, slots[i].postings);
+            }
+        }
+    }
+
+    // Sort and compact the posting list of every key; lengths are the document lengths handed on to
+    // PostingList::finalize
+    void finalize(const int *lengths = nullptr, size_t lengthCount = 0)
+    {
+        for (size_t i = 0; i < capacity; i++)
+        {
+            if (control[i] != EMPTY)
+            {
+                slots[i].postings.finalize(lengths, lengthCount);
+            }
+        }
+    }
+
+    // Print the hash table to an output stream
+    void printHash(std::ostream &out) const
+    {
+        forEach([&out](const Comparable &comp, const PostingList<Value> &postings)
+                {
+                    out << comp << ":";
+                    postings.print(out);
+                    out << std::endl; });
+    }
+};
+#endif
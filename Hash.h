@@ -1,44 +1,47 @@
 #ifndef HASH_H
 #define HASH_H
-#include <map>
+#include "PostingList.h"
+#include "NodePool.h"
 #include <functional>
 #include <ostream>
+#include <utility>
 
-// Template class for a hash table
-template <typename Comparable, typename Value>
+// Template class for a hash table; nodes are allocated through the Alloc policy (see NodePool.h)
+template <typename Comparable, typename Value, template <typename> class Alloc = NodePool>
 class Hash
 {
 private:
     // Nested struct representing a node in the hash table
     struct HashNode
     {
-        Comparable comp;           // Key of the node
-        std::map<Value, int> maps; // Map to store values and their counts
-        HashNode *next;            // Pointer to the next node in the same bucket
+        Comparable comp;             // Key of the node
+        PostingList<Value> postings; // Values and their counts, stored contiguously
+        HashNode *next;              // Pointer to the next node in the same bucket
 
         // Constructor for a node with a key and a value
         HashNode(Comparable c, Value v)
         {
             comp = c;
-            maps[v] = 1;
+            postings.add(v);
             next = nullptr;
         }
 
-        // Constructor for a node with a key and a map of values
-        HashNode(Comparable c, std::map<Value, int> v)
+        // Constructor for a node with a key and a list of values
+        HashNode(Comparable c, PostingList<Value> v)
         {
             comp = c;
-            maps = v;
+            postings = std::move(v);
             next = nullptr;
         }
 
         // Copy constructor for a node
-        HashNode(const HashNode &n) : comp(n.comp), maps(n.maps), next(nullptr) {}
+        HashNode(const HashNode &n) : comp(n.comp), postings(n.postings), next(nullptr) {}
     };
 
-    int capacity;     // Capacity of the hash table
-    int size;         // Current size of the hash table
-    HashNode **table; // Pointer to the array of hash buckets
+    int capacity;         // Capacity of the hash table
+    int size;             // Current size of the hash table
+    HashNode **table;     // Pointer to the array of hash buckets
+    Alloc<HashNode> pool; // Allocates the nodes
 
     // Method to resize and rehash the hash table
     void rehash()
@@ -53,10 +56,10 @@ private:
             HashNode *itr = storeTable[i];
             while (itr != nullptr)
             {
-                secondInsert(itr->comp, itr->maps);
+                secondInsert(itr->comp, std::move(itr->postings));
                 HashNode *temp = itr;
                 itr = itr->next;
-                delete temp;
+                pool.destroy(temp);
             }
             storeTable[i] = nullptr;
         }
@@ -64,7 +67,7 @@ private:
     }
 
     // Hash function to compute the bucket index
-    int hash(Comparable comp)
+    int hash(const Comparable &comp) const
     {
         int index = std::hash<Comparable>{}(comp);
         return abs(index % capacity);
@@ -90,14 +93,30 @@ public:
     {
         if (this != &rhs)
         {
-            clear();
             clone(rhs);
         }
         return *this;
     }
 
+    Hash(Hash &&rhs) : Hash() // move constructor: rhs is left with our fresh, empty table
+    {
+        std::swap(capacity, rhs.capacity);
+        std::swap(size, rhs.size);
+        std::swap(table, rhs.table);
+        std::swap(pool, rhs.pool);
+    }
+
+    Hash &operator=(Hash &&rhs) // move assignment operator: rhs takes our old table and frees it
+    {
+        std::swap(capacity, rhs.capacity);
+        std::swap(size, rhs.size);
+        std::swap(table, rhs.table);
+        std::swap(pool, rhs.pool);
+        return *this;
+    }
+
     // Get the current size of the hash table
-    int getSize()
+    int getSize() const
     {
         return size;
     }
@@ -111,10 +130,11 @@ public:
             {
                 HashNode *prev = itr;
                 itr = itr->next;
-                delete prev;
+                pool.destroy(prev);
             }
             table[i] = nullptr;
         }
+        pool.release(); // Every node is gone, so the pool's memory goes back in one go
         delete[] table;
         createHash(capacity);
         size = 0;
@@ -133,6 +153,11 @@ public:
 
     void clone(const Hash &copy) // clones a hash
     {
+        if (table != nullptr) // Release the current contents; the copy constructor starts without a table
+        {
+            clear();
+            delete[] table;
+        }
         createHash(copy.capacity);
         size = copy.size;
         for (int i = 0; i < capacity; i++)
@@ -141,7 +166,7 @@ public:
             HashNode *prev = nullptr;
             while (itr1 != nullptr)
             {
-                HashNode *newNode = new HashNode(*itr1);
+                HashNode *newNode = pool.create(*itr1);
                 if (prev == nullptr)
                 {
                     table[i] = newNode;
@@ -161,7 +186,7 @@ public:
         int index = hash(comp);
         if (table[index] == nullptr)
         {
-            table[index] = new HashNode(comp, val);
+            table[index] = pool.create(comp, val);
             size++;
         }
         else
@@ -172,14 +197,7 @@ public:
             {
                 if (itr->comp == comp)
                 {
-                    if (itr->maps.find(val) == itr->maps.end())
-                    {
-                        itr->maps[val] = 1;
-                    }
-                    else
-                    {
-                        itr->maps[val] += 1;
-                    }
+                    itr->postings.add(val);
                     break;
                 }
                 prev = itr;
@@ -189,7 +207,7 @@ public:
             {
                 if (prev != nullptr)
                 {
-                    prev->next = new HashNode(comp, val);
+                    prev->next = pool.create(comp, val);
                     size++;
                 }
             }
@@ -206,8 +224,8 @@ public:
         int index = hash(comp);
         if (table[index] == nullptr)
         {
-            table[index] = new HashNode(comp, val);
-            table[index]->maps[val] = freq;
+            table[index] = pool.create(comp, PostingList<Value>());
+            table[index]->postings.add(val, freq);
             size++;
         }
         else
@@ -218,14 +236,7 @@ public:
             {
                 if (itr->comp == comp)
                 {
-                    if (itr->maps.find(val) == itr->maps.end())
-                    {
-                        itr->maps[val] = freq;
-                    }
-                    else
-                    {
-                        itr->maps[val] += freq;
-                    }
+                    itr->postings.add(val, freq);
                     break;
                 }
                 prev = itr;
@@ -235,7 +246,8 @@ public:
             {
                 if (prev != nullptr)
                 {
-                    prev->next = new HashNode(comp, val);
+                    prev->next = pool.create(comp, PostingList<Value>());
+                    prev->next->postings.add(val, freq);
                     size++;
                 }
             }
@@ -246,6 +258,42 @@ public:
         }
     }
 
+    // Add every key-value-count triple of another hash table into this one
+    void merge(const Hash &rhs)
+    {
+        merge(rhs, [](const Value &v)
+              { return v; });
+    }
+
+    // Add every key-value-count triple of another hash table into this one, translating each value with remap
+    template <typename Remap>
+    void merge(const Hash &rhs, Remap remap)
+    {
+        for (int i = 0; i < rhs.capacity; i++)
+        {
+            HashNode *itr = rhs.table[i];
+            while (itr != nullptr)
+            {
+                itr->postings.forEach([this, itr, &remap](const Value &v, int freq)
+                                      { insert(itr->comp, remap(v), freq); });
+                itr = itr->next;
+            }
+        }
+    }
+
+    // Call visit(key, postings) for every key in the table, in bucket order
+    template <typename Visit>
+    void forEach(Visit visit) const
+    {
+        for (int i = 0; i < capacity; i++)
+        {
+            for (HashNode *itr = table[i]; itr != nullptr; itr = itr->next)
+            {
+                visit(itr->comp, itr->postings);
+            }
+        }
+    }
+
     // Print the hash table to an output stream
     void printHash(std::ostream &out)
     {
@@ -255,23 +303,20 @@ public:
             while (itr != nullptr)
             {
                 out << itr->comp << ":";
-                for (const auto &itr : itr->maps)
-                {
-                    out << itr.first << "," << itr.second << ";";
-                }
+                itr->postings.print(out);
                 out << std::endl;
                 itr = itr->next;
             }
         }
     }
 
-    // Insert a key with a map of values into the hash table
-    void secondInsert(Comparable comp, std::map<Value, int> val) // inserts a comp into a hash at val
+    // Insert a key with a list of values into the hash table
+    void secondInsert(Comparable comp, PostingList<Value> val) // inserts a comp into a hash at val
     {
         int index = hash(comp);
         if (table[index] == nullptr)
         {
-            table[index] = new HashNode(comp, val);
+            table[index] = pool.create(comp, std::move(val));
             size++;
         }
         else
@@ -282,10 +327,8 @@ public:
             {
                 if (itr->comp == comp)
                 {
-                    for (const auto &entry : val)
-                    {
-                        itr->maps[entry.first] = entry.second;
-                    }
+                    val.forEach([itr](const Value &v, int freq)
+                                { itr->postings.add(v, freq); }); // Works on a finalized list as well
                     break;
                 }
                 prev = itr;
@@ -293,7 +336,7 @@ public:
             }
             if (itr == nullptr)
             {
-                prev->next = new HashNode(comp, val);
+                prev->next = pool.create(comp, std::move(val));
                 size++;
             }
         }
@@ -302,9 +345,22 @@ public:
             rehash();
         }
     }
-    
-    // Find and return the map of values for a given key
-    std::map<Value, int> find(const Comparable comp) // finds a comp in the hash
+
+    // Finalize every posting list once insertion is done (sorts and compacts them); lengths are the document
+    // lengths handed on to PostingList::finalize
+    void finalize(const int *lengths = nullptr, size_t lengthCount = 0)
+    {
+        for (int i = 0; i < capacity; i++)
+        {
+            for (HashNode *itr = table[i]; itr != nullptr; itr = itr->next)
+            {
+                itr->postings.finalize(lengths, lengthCount);
+            }
+        }
+    }
+
+    // Find the posting list for a given key; returns a pointer into the table, or nullptr if the key is not in the hash
+    const PostingList<Value> *find(const Comparable &comp) const // finds a comp in the hash
     {
         int index = hash(comp);
         HashNode *itr = table[index];
@@ -312,11 +368,11 @@ public:
         {
             if (itr->comp == comp)
             {
-                return itr->maps;
+                return &itr->postings;
             }
             itr = itr->next;
         }
-        return std::map<Value, int>();
+        return nullptr;
     }
 };
 #endif
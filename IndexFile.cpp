@@ -0,0 +1,383 @@
+#include "IndexFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Appends raw bytes to the output buffer
+static void append(std::vector<char> &out, const void *bytes, size_t length)
+{
+    const char *begin = static_cast<const char *>(bytes);
+    out.insert(out.end(), begin, begin + length);
+}
+
+// Pads the output buffer to the next 8-byte boundary and returns the resulting offset
+static uint64_t align(std::vector<char> &out)
+{
+    out.resize((out.size() + 7) & ~size_t(7), 0);
+    return out.size();
+}
+
+// Serializes the index into one buffer and writes it out in a single pass
+bool IndexFile::write(const std::string &path, const Terms (&dictionaries)[SECTION_COUNT],
+                      const std::vector<std::string> &docs, const std::vector<std::string> &titles,
+                      const std::vector<std::string> &publications, const std::vector<std::string> &dates,
+                      const std::vector<int> &wordCount, std::string_view stopWords,
+                      const std::vector<const PositionList *> *positions)
+{
+    std::vector<char> out(sizeof(FileHeader), 0); // The header is filled in once all offsets are known
+    FileHeader head;
+    std::memset(&head, 0, sizeof(head));
+    std::memcpy(head.magic, "SSIX", 4);
+    head.version = VERSION;
+    head.docCount = docs.size();
+
+    for (int d = 0; d < SECTION_COUNT; d++)
+    {
+        const Terms &terms = dictionaries[d];
+        Dictionary &dict = head.dictionaries[d];
+        dict.termCount = terms.size();
+
+        // Compressed posting lists, one after the other. Finalized lists are compressed already and are copied as
+        // they are; lists of an index that was never finalized are encoded here
+        std::vector<uint8_t> postings;
+        std::vector<uint64_t> postingOffsets;
+        postingOffsets.reserve(terms.size());
+        for (const auto &term : terms)
+        {
+            postingOffsets.push_back(postings.size());
+            PostingView<DocId> list = term.second->view();
+            if (list.compressed())
+            {
+                postings.insert(postings.end(), list.packedData(), list.packedData() + list.packedBytes());
+            }
+            else
+            {
+                BlockCodec::encode(list.idData(), list.freqData(), list.size(), postings, wordCount.data(), wordCount.size());
+            }
+        }
+
+        // Term entries point into the key bytes and the posting bytes that follow them
+        dict.termsOffset = align(out);
+        uint64_t keyOffset = 0;
+        for (size_t t = 0; t < terms.size(); t++)
+        {
+            TermEntry entry;
+            entry.keyOffset = keyOffset;
+            entry.postingOffset = postingOffsets[t];
+            entry.keyLength = terms[t].first.size();
+            entry.postingCount = terms[t].second->size();
+            append(out, &entry, sizeof(entry));
+            keyOffset += terms[t].first.size();
+        }
+        dict.keysOffset = align(out);
+        for (const auto &term : terms)
+        {
+            append(out, term.first.data(), term.first.size());
+        }
+        dict.postingsOffset = align(out);
+        dict.postingsSize = postings.size();
+        append(out, postings.data(), postings.size());
+    }
+
+    // Document table: string offsets, then the paths, titles, publications and dates themselves
+    const std::vector<std::string> *fields[DOC_FIELD_COUNT] = {&docs, &titles, &publications, &dates};
+    head.docOffsetsOffset = align(out);
+    uint64_t stringOffset = 0;
+    for (size_t i = 0; i < docs.size(); i++)
+    {
+        for (const std::vector<std::string> *field : fields)
+        {
+            append(out, &stringOffset, sizeof(stringOffset));
+            stringOffset += i < field->size() ? (*field)[i].size() : 0; // Missing fields are stored empty
+        }
+    }
+    append(out, &stringOffset, sizeof(stringOffset));
+    head.docStringsOffset = align(out);
+    for (size_t i = 0; i < docs.size(); i++)
+    {
+        for (const std::vector<std::string> *field : fields)
+        {
+            if (i < field->size())
+            {
+                append(out, (*field)[i].data(), (*field)[i].size());
+            }
+        }
+    }
+
+    // Word counts, padded with zeros for documents without indexed words
+    head.wordCountOffset = align(out);
+    double totalWords = 0;
+    for (size_t i = 0; i < docs.size(); i++)
+    {
+        int count = i < wordCount.size() ? wordCount[i] : 0;
+        append(out, &count, sizeof(count));
+        totalWords += count;
+    }
+    head.averageWordCount = docs.empty() ? 0 : totalWords / docs.size();
+
+    // Position lists of the words, with one offset per word and a final one where the last list ends; a word
+    // without a list gets an empty one
+    if (positions != nullptr)
+    {
+        std::vector<uint8_t> bytes;
+        std::vector<uint64_t> offsets;
+        offsets.reserve(positions->size() + 1);
+        for (const PositionList *list : *positions)
+        {
+            offsets.push_back(bytes.size());
+            if (list != nullptr)
+            {
+                list->encode(bytes);
+            }
+        }
+        offsets.push_back(bytes.size());
+        head.positionOffsetsOffset = align(out);
+        append(out, offsets.data(), offsets.size() * sizeof(uint64_t));
+        head.positionsOffset = align(out);
+        append(out, bytes.data(), bytes.size());
+    }
+
+    // Stopwords the index was built with, for the query side to leave out as well
+    head.stopWordsOffset = align(out);
+    head.stopWordsSize = stopWords.size();
+    append(out, stopWords.data(), stopWords.size());
+
+    head.fileSize = align(out);
+    std::memcpy(out.data(), &head, sizeof(head));
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output.is_open())
+    {
+        return false;
+    }
+    output.write(out.data(), out.size());
+    return output.good();
+}
+
+// Maps an index file read-only and checks its header
+std::shared_ptr<const IndexFile> IndexFile::open(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Could not open index file: " << path << std::endl;
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(FileHeader))
+    {
+        std::cerr << "Index file is too small: " << path << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+    size_t length = info.st_size;
+    void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping stays valid after the descriptor is closed
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Could not map index file: " << path << std::endl;
+        return nullptr;
+    }
+
+    std::shared_ptr<const IndexFile> file(new IndexFile(static_cast<const char *>(mapping), length));
+    const FileHeader &head = file->header();
+    if (std::memcmp(head.magic, "SSIX", 4) != 0 || head.version != VERSION || head.fileSize != length)
+    {
+        std::cerr << "Index file has an unsupported format or version, please rebuild it: " << path << std::endl;
+        return nullptr;
+    }
+    if (!file->valid())
+    {
+        std::cerr << "Index file is truncated or corrupted, please rebuild it: " << path << std::endl;
+        return nullptr;
+    }
+    return file;
+}
+
+// Checks the header's offsets and sizes and the offset tables against the length of the mapping
+bool IndexFile::valid() const
+{
+    const FileHeader &head = header();
+    for (const Dictionary &dict : head.dictionaries)
+    {
+        if (!fits(dict.termsOffset, dict.termCount, sizeof(TermEntry), alignof(TermEntry)) ||
+            !fits(dict.keysOffset, 0, 1) || !fits(dict.postingsOffset, dict.postingsSize, 1))
+        {
+            return false;
+        }
+        // Keys and posting lists follow each other in term order, and each list has room for its block headers
+        const TermEntry *terms = at<TermEntry>(dict.termsOffset);
+        const uint64_t keyBytes = size - dict.keysOffset;
+        uint64_t keyEnd = 0;
+        for (uint64_t t = 0; t < dict.termCount; t++)
+        {
+            const TermEntry &entry = terms[t];
+            const uint64_t postingEnd = t + 1 < dict.termCount ? terms[t + 1].postingOffset : dict.postingsSize;
+            if (entry.keyOffset < keyEnd || entry.keyOffset > keyBytes || entry.keyLength > keyBytes - entry.keyOffset ||
+                entry.postingOffset > postingEnd || postingEnd > dict.postingsSize ||
+                BlockCodec::blockCount(entry.postingCount) > (postingEnd - entry.postingOffset) / sizeof(BlockCodec::Header))
+            {
+                return false;
+            }
+            keyEnd = entry.keyOffset + entry.keyLength;
+        }
+    }
+
+    // Document strings are delimited by consecutive offsets into the string bytes
+    if (head.docCount > size || !fits(head.docOffsetsOffset, DOC_FIELD_COUNT * head.docCount + 1, sizeof(uint64_t), alignof(uint64_t)) ||
+        !fits(head.docStringsOffset, 0, 1) || !fits(head.wordCountOffset, head.docCount, sizeof(int), alignof(int)))
+    {
+        return false;
+    }
+    const uint64_t *docOffsets = at<uint64_t>(head.docOffsetsOffset);
+    const uint64_t docOffsetCount = DOC_FIELD_COUNT * head.docCount + 1;
+    if (!std::is_sorted(docOffsets, docOffsets + docOffsetCount) || docOffsets[docOffsetCount - 1] > size - head.docStringsOffset)
+    {
+        return false;
+    }
+
+    // Position lists are delimited like the document strings, with one offset per word and a final one
+    if (head.positionOffsetsOffset != 0)
+    {
+        const uint64_t wordCount = head.dictionaries[WORDS].termCount;
+        if (!fits(head.positionOffsetsOffset, wordCount + 1, sizeof(uint64_t), alignof(uint64_t)) || !fits(head.positionsOffset, 0, 1))
+        {
+            return false;
+        }
+        const uint64_t *positionOffsets = at<uint64_t>(head.positionOffsetsOffset);
+        if (!std::is_sorted(positionOffsets, positionOffsets + wordCount + 1) || positionOffsets[wordCount] > size - head.positionsOffset)
+        {
+            return false;
+        }
+    }
+    return fits(head.stopWordsOffset, head.stopWordsSize, 1);
+}
+
+IndexFile::~IndexFile()
+{
+    munmap(const_cast<char *>(data), size);
+}
+
+// Binary search over the sorted term entries of one dictionary
+const IndexFile::TermEntry *IndexFile::lookup(Section section, std::string_view key) const
+{
+    const Dictionary &dict = header().dictionaries[section];
+    const TermEntry *terms = at<TermEntry>(dict.termsOffset);
+    const char *keys = at<char>(dict.keysOffset);
+    auto keyOf = [keys](const TermEntry &entry)
+    { return std::string_view(keys + entry.keyOffset, entry.keyLength); };
+
+    const TermEntry *itr = std::lower_bound(terms, terms + dict.termCount, key, [&keyOf](const TermEntry &entry, std::string_view k)
+                                            { return keyOf(entry) < k; });
+    return itr == terms + dict.termCount || keyOf(*itr) != key ? nullptr : itr;
+}
+
+// Posting list of a key: its slice of the dictionary's posting bytes, which ends where the next key's begins
+PostingView<DocId> IndexFile::find(Section section, std::string_view key) const
+{
+    const TermEntry *entry = lookup(section, key);
+    if (entry == nullptr)
+    {
+        return PostingView<DocId>();
+    }
+    const Dictionary &dict = header().dictionaries[section];
+    const TermEntry *terms = at<TermEntry>(dict.termsOffset);
+    uint64_t end = entry + 1 < terms + dict.termCount ? entry[1].postingOffset : dict.postingsSize;
+    return PostingView<DocId>(at<uint8_t>(dict.postingsOffset) + entry->postingOffset, end - entry->postingOffset,
+                              entry->postingCount);
+}
+
+// Position list of a word: the word's dictionary entry is found as for its postings, and its index in the
+// dictionary picks its slice of the position bytes
+PositionView IndexFile::findPositions(std::string_view word) const
+{
+    const TermEntry *entry = hasPositions() ? lookup(WORDS, word) : nullptr;
+    if (entry == nullptr)
+    {
+        return PositionView();
+    }
+    const uint64_t *offset = at<uint64_t>(header().positionOffsetsOffset) + (entry - at<TermEntry>(header().dictionaries[WORDS].termsOffset));
+    if (offset[1] == offset[0])
+    {
+        return PositionView(); // The word was written without positions
+    }
+    return PositionView(at<uint8_t>(header().positionsOffset) + offset[0], offset[1] - offset[0], entry->postingCount);
+}
+
+// Returns whether the file holds word positions
+bool IndexFile::hasPositions() const
+{
+    return header().positionOffsetsOffset != 0;
+}
+
+// Returns the stopword bytes
+std::string_view IndexFile::getStopWords() const
+{
+    return std::string_view(at<char>(header().stopWordsOffset), header().stopWordsSize);
+}
+
+// Returns the number of keys in one dictionary
+size_t IndexFile::getTermCount(Section section) const
+{
+    return header().dictionaries[section].termCount;
+}
+
+// Returns the number of documents in the file
+size_t IndexFile::getDocCount() const
+{
+    return header().docCount;
+}
+
+// Returns one string of a document: its slice of the doc string bytes, delimited by consecutive offsets
+std::string_view IndexFile::getDocField(DocId id, DocField field) const
+{
+    const uint64_t *offset = at<uint64_t>(header().docOffsetsOffset) + DOC_FIELD_COUNT * size_t(id) + field;
+    return std::string_view(at<char>(header().docStringsOffset) + offset[0], offset[1] - offset[0]);
+}
+
+// Returns the file path of a document
+std::string_view IndexFile::getDocPath(DocId id) const
+{
+    return getDocField(id, PATH);
+}
+
+// Returns the title of a document
+std::string_view IndexFile::getTitle(DocId id) const
+{
+    return getDocField(id, TITLE);
+}
+
+// Returns the publication (site) of a document
+std::string_view IndexFile::getPublication(DocId id) const
+{
+    return getDocField(id, PUBLICATION);
+}
+
+// Returns the publication date of a document
+std::string_view IndexFile::getDate(DocId id) const
+{
+    return getDocField(id, DATE);
+}
+
+// Returns the word count of a document
+int IndexFile::getWordCount(DocId id) const
+{
+    return id < header().docCount ? at<int>(header().wordCountOffset)[id] : 0;
+}
+
+// Returns the word counts of all documents as one array indexed by document ID
+const int *IndexFile::getWordCounts() const
+{
+    return at<int>(header().wordCountOffset);
+}
+
+// Returns the average word count of the documents in the file
+double IndexFile::getAverageWordCount() const
+{
+    return header().averageWordCount;
+}
@@ -0,0 +1,163 @@
+#ifndef INDEX_FILE_H
+#define INDEX_FILE_H
+
+// Including necessary header files
+#include "PostingList.h"  // Include posting lists and views
+#include "PositionList.h" // Include word position lists
+#include <cstdint>        // Standard library for fixed width integer types
+#include <memory>         // Standard library for shared pointers
+#include <string>         // Standard library for string handling
+#include <string_view>    // Standard library for non-owning string views
+#include <utility>        // Standard library for pairs
+#include <vector>         // Standard library for vector data structure
+
+// Class definition for IndexFile: the binary, memory-mappable persistence format of an index.
+//
+// Layout (native byte order, every section starts on an 8-byte boundary):
+//   FileHeader
+//   for words, people and orgs: TermEntry[termCount] sorted by key, key bytes, posting bytes (each term's list
+//     block-compressed as described in BlockCodec.h, one list after the other)
+//   uint64 docOffsets[DOC_FIELD_COUNT * docCount + 1] into the doc string bytes (path, title, publication and
+//     date of each document, in that order)
+//   doc string bytes
+//   int32 wordCount[docCount]
+//   only in indexes built with positions: uint64 positionOffsets[words termCount + 1] into the position bytes,
+//     then the position bytes (each word's list encoded as described in PositionList.h, in dictionary order)
+//   stopword bytes: the words left out of the index, one per line, so queries leave out the same ones
+// The header also carries the average word count so rankers get their corpus statistics without a scan, and the
+// document table holds everything a result line shows, so listing results never touches the documents' JSON.
+//
+// Queries read straight out of the mapping, so opening an index costs one mmap instead of a rebuild.
+class IndexFile
+{
+public:
+    // The three dictionaries stored in a file
+    enum Section
+    {
+        WORDS = 0,
+        PEOPLE = 1,
+        ORGS = 2,
+        SECTION_COUNT = 3
+    };
+
+    // Terms of one dictionary, sorted by key, with their posting lists
+    typedef std::vector<std::pair<std::string, const PostingList<DocId> *>> Terms;
+
+    // Writes an index to path; returns false if the file could not be written
+    static bool write(const std::string &path, const Terms (&dictionaries)[SECTION_COUNT],
+                      const std::vector<std::string> &docs, const std::vector<std::string> &titles,
+                      const std::vector<std::string> &publications, const std::vector<std::string> &dates,
+                      const std::vector<int> &wordCount, std::string_view stopWords,
+                      const std::vector<const PositionList *> *positions = nullptr);
+
+    // Maps the index file at path; returns nullptr (after printing the reason) if it is missing or invalid
+    static std::shared_ptr<const IndexFile> open(const std::string &path);
+
+    ~IndexFile();
+    IndexFile(const IndexFile &) = delete;
+    IndexFile &operator=(const IndexFile &) = delete;
+
+    // Posting list of a key in one dictionary (an empty view if the key is not in it)
+    PostingView<DocId> find(Section, std::string_view key) const;
+
+    // Positions of a word, aligned with its posting list (an empty view if the word or the positions are missing)
+    PositionView findPositions(std::string_view word) const;
+
+    // Whether the file was written with word positions
+    bool hasPositions() const;
+
+    // Stopwords the index was built with, one per line
+    std::string_view getStopWords() const;
+
+    // Number of keys in one dictionary
+    size_t getTermCount(Section) const;
+
+    // Document table
+    size_t getDocCount() const;
+    std::string_view getDocPath(DocId) const;
+    std::string_view getTitle(DocId) const;
+    std::string_view getPublication(DocId) const;
+    std::string_view getDate(DocId) const;
+    int getWordCount(DocId) const;
+    const int *getWordCounts() const; // All word counts, indexed by document ID
+    double getAverageWordCount() const;
+
+private:
+    static const uint32_t VERSION = 7; // Bump whenever the layout changes
+
+    // Strings stored for each document, in file order
+    enum DocField
+    {
+        PATH = 0,
+        TITLE = 1,
+        PUBLICATION = 2,
+        DATE = 3,
+        DOC_FIELD_COUNT = 4
+    };
+
+    // Location of one dictionary inside the file
+    struct Dictionary
+    {
+        uint64_t termCount;
+        uint64_t termsOffset;    // TermEntry array
+        uint64_t keysOffset;     // Concatenated key bytes
+        uint64_t postingsOffset; // Concatenated compressed posting lists
+        uint64_t postingsSize;   // Bytes of all the posting lists together
+    };
+
+    // Fixed-size header at the start of the file
+    struct FileHeader
+    {
+        char magic[4]; // "SSIX"
+        uint32_t version;
+        uint64_t fileSize;
+        uint64_t docCount;
+        Dictionary dictionaries[SECTION_COUNT];
+        uint64_t docOffsetsOffset;
+        uint64_t docStringsOffset;
+        uint64_t wordCountOffset;
+        double averageWordCount;
+        uint64_t positionOffsetsOffset; // 0 if the index has no positions
+        uint64_t positionsOffset;
+        uint64_t stopWordsOffset;
+        uint64_t stopWordsSize;
+    };
+
+    // One key of a dictionary and the slice of the posting arrays that belongs to it
+    struct TermEntry
+    {
+        uint64_t keyOffset;     // Relative to the dictionary's key bytes
+        uint64_t postingOffset; // Relative to the dictionary's posting bytes; the list ends where the next begins
+        uint32_t keyLength;
+        uint32_t postingCount;
+    };
+
+    const char *data; // Start of the mapping
+    size_t size;      // Length of the mapping
+
+    IndexFile(const char *d, size_t s) : data{d}, size{s} {}
+
+    // Whether every section the header points to lies inside the mapping, with offset tables that only grow and
+    // stay inside the bytes they index, so no lookup can read past the end of a truncated or corrupted file
+    bool valid() const;
+
+    // Whether count elements of size bytes, starting at offset, fit in the mapping and are aligned for their type
+    bool fits(uint64_t offset, uint64_t count, size_t bytes, size_t alignment = 1) const
+    {
+        return offset <= size && offset % alignment == 0 && count <= (size - offset) / bytes;
+    }
+
+    // Entry of a key in one dictionary, nullptr if the key is not in it
+    const TermEntry *lookup(Section, std::string_view key) const;
+
+    // One string of a document's entry in the document table
+    std::string_view getDocField(DocId, DocField) const;
+
+    const FileHeader &header() const { return *reinterpret_cast<const FileHeader *>(data); }
+
+    // Typed pointer to a section of the mapping
+    template <typename T>
+    const T *at(uint64_t offset) const { return reinterpret_cast<const T *>(data + offset); }
+};
+
+#endif
@@ -1,181 +1,319 @@
 #include "IndexHandler.h"
+#include "Scorer.h"
 
-// Returns a map of words that match the input word
-std::map<std::string, int> IndexHandler::getWords(std::string word)
+// Name of the binary persistence file
+static const char *PERSISTENCE_FILE = "persistence.idx";
+
+// Returns the posting list of the input word (empty if it is not indexed)
+PostingView<DocId> IndexHandler::getWords(const std::string &word) const
 {
-    return words.contains(word); // Checks if the word exists in the AVL tree and returns it
+    if (file)
+    {
+        return file->find(IndexFile::WORDS, word); // Binary search in the mapped dictionary
+    }
+    const PostingList<DocId> *postings = words.find(word); // Looks the word up in the word dictionary
+    return postings != nullptr ? postings->view() : PostingView<DocId>();
 }
 
-// Returns the count of occurrences of a specific word in the index
-int IndexHandler::getWordCount(std::string title)
+// Returns the positions of the input word (empty if it is not indexed or the index has no positions)
+PositionView IndexHandler::getPositions(const std::string &word) const
 {
-    return wordCount[title]; // Accesses the word count from the map using the provided title
+    if (file)
+    {
+        return file->findPositions(word);
+    }
+    auto itr = positions.find(word);
+    return itr != positions.end() ? itr->second.view() : PositionView();
 }
 
-// Returns a map of people that match the input person
-std::map<std::string, int> IndexHandler::getPeople(std::string person)
+// Turns position recording on for the documents indexed from now on
+void IndexHandler::enablePositions()
 {
-    return people.find(person); // Searches for the person in the people hash table and returns it
+    positional = true;
 }
 
-// Returns a map of organizations that match the input organization
-std::map<std::string, int> IndexHandler::getOrgs(std::string org)
+// Returns whether word positions are recorded (or were persisted, for a mapped index)
+bool IndexHandler::hasPositions() const
 {
-    return orgs.find(org); // Searches for the organization in the orgs hash table and returns it
+    return file ? file->hasPositions() : positional;
 }
 
-// Adds or updates the word count in the index
-void IndexHandler::addWordCount(std::string title, int count)
+// Sets the stopword list
+void IndexHandler::setStopWords(const StopWords &words)
 {
-    wordCount[title] = count; // Updates or inserts the word count into the map
+    stopWords = words;
 }
 
-// Adds a word and its associated filepath to the words AVL tree
-void IndexHandler::addWords(std::string word, std::string filepath)
+// Returns the stopword list; a mapped index has it loaded from the file
+const StopWords &IndexHandler::getStopWords() const
 {
-    words.insert(word, filepath); // Inserts a new word along with its filepath into the AVL tree
+    return stopWords;
 }
 
-// Adds a person and their associated filepath to the people hash table
-void IndexHandler::addPeople(std::string person, std::string filepath)
+// Returns the number of indexed words in a specific document
+int IndexHandler::getWordCount(DocId id) const
 {
-    people.insert(person, filepath); // Inserts a new person along with filepath into the hash table
+    if (file)
+    {
+        return file->getWordCount(id);
+    }
+    return id < wordCount.size() ? wordCount[id] : 0; // Documents without indexed words have a count of 0
 }
 
-// Adds an organization and its associated filepath to the orgs hash table
-void IndexHandler::addOrgs(std::string org, std::string filepath)
+// Returns the contiguous word count table, which the rankers index by document ID
+const int *IndexHandler::getWordCounts() const
 {
-    orgs.insert(org, filepath); // Inserts a new organization along with filepath into the hash table
+    return file ? file->getWordCounts() : wordCount.data();
 }
 
-// Adds a document's filepath to the document list
-void IndexHandler::addDocument(std::string filepath)
+// Returns the average number of indexed words per document
+double IndexHandler::getAverageWordCount() const
 {
-    docs.push_back(filepath); // Appends the new document's filepath to the vector
+    return file ? file->getAverageWordCount() : averageWordCount;
 }
 
-// Returns the number of documents in the index
-int IndexHandler::getDocSize()
+// Returns the relative word counts of the current snapshot, which the scorers reference instead of rebuilding them
+std::shared_ptr<const std::vector<float>> IndexHandler::getRelativeWordCounts() const
+{
+    return relativeWordCounts;
+}
+
+// Returns the file path of a specific document
+std::string IndexHandler::getDocPath(DocId id) const
+{
+    return file ? std::string(file->getDocPath(id)) : docs[id];
+}
+
+// Returns the title of a specific document
+std::string IndexHandler::getTitle(DocId id) const
+{
+    return file ? std::string(file->getTitle(id)) : titles[id];
+}
+
+// Returns the publication of a specific document
+std::string IndexHandler::getPublication(DocId id) const
 {
-    return docs.size(); // Returns the size of the documents vector
+    return file ? std::string(file->getPublication(id)) : publications[id];
 }
 
-// Creates a persistent storage of the index data
-void IndexHandler::createPersistence()
+// Returns the publication date of a specific document
+std::string IndexHandler::getDate(DocId id) const
 {
-    // Open a file stream for writing
-    std::ofstream output("persistence.txt");
+    return file ? std::string(file->getDate(id)) : dates[id];
+}
 
-    // Check if the file stream is open
-    if (!output.is_open())
+// Returns the posting list of the input person (empty if they are not indexed)
+PostingView<DocId> IndexHandler::getPeople(const std::string &person) const
+{
+    if (file)
     {
-        std::cerr << "Error! File could not be opened!" << std::endl;
-        exit(-1); // Exit if file could not be opened
+        return file->find(IndexFile::PEOPLE, person);
     }
+    const PostingList<DocId> *postings = people.find(person); // Searches for the person in the people hash table
+    return postings != nullptr ? postings->view() : PostingView<DocId>();
+}
 
-    // Write words to the file, preceded by a comment for identification
-    output << "//words" << std::endl;
-    words.printTree(output); // Calls a method to write the AVL tree contents to the file
+// Returns the posting list of the input organization (empty if it is not indexed)
+PostingView<DocId> IndexHandler::getOrgs(const std::string &org) const
+{
+    if (file)
+    {
+        return file->find(IndexFile::ORGS, org);
+    }
+    const PostingList<DocId> *postings = orgs.find(org); // Searches for the organization in the orgs hash table
+    return postings != nullptr ? postings->view() : PostingView<DocId>();
+}
 
-    // Write people to the file
-    output << "//people" << std::endl;
-    people.printHash(output); // Calls a method to write the people hash table contents to the file
+// Adds or updates the word count of a document in the index
+void IndexHandler::addWordCount(DocId id, int count)
+{
+    if (id >= wordCount.size())
+    {
+        wordCount.resize(id + 1, 0); // Grow the table to cover the new document
+    }
+    wordCount[id] = count;
+    relativeWordCounts = nullptr; // Stale until the next finalize()
+}
 
-    // Write organizations to the file
-    output << "//orgs" << std::endl;
-    orgs.printHash(output); // Calls a method to write the orgs hash table contents to the file
+// Adds a word and its associated document to the words dictionary
+void IndexHandler::addWords(const std::string &word, DocId id)
+{
+    words.insert(word, id); // Inserts a new word along with its document ID into the dictionary
+}
 
-    // Write documents to the file
-    output << "//docs" << std::endl;
-    for (const auto &itr : docs)
+// Adds the position of a word in a document to the word's position list
+void IndexHandler::addPosition(const std::string &word, DocId id, uint32_t position)
+{
+    if (positional)
     {
-        output << itr << "$" << std::endl; // Write each document's path, ending with a '$' symbol
+        positions[word].add(id, position);
     }
+}
+
+// Adds a person and their associated document to the people hash table
+void IndexHandler::addPeople(const std::string &person, DocId id)
+{
+    people.insert(person, id); // Inserts a new person along with document ID into the hash table
+}
+
+// Adds an organization and its associated document to the orgs hash table
+void IndexHandler::addOrgs(const std::string &org, DocId id)
+{
+    orgs.insert(org, id); // Inserts a new organization along with document ID into the hash table
+}
 
-    // Write word counts to the file
-    output << "//wordCount" << std::endl;
-    for (const auto &itr : wordCount)
+// Adds a document's filepath, title, publication and date to the document table and returns the ID assigned to it
+DocId IndexHandler::addDocument(std::string filepath, std::string title, std::string publication, std::string date)
+{
+    docs.push_back(filepath); // IDs are dense: a document's ID is its position in the table
+    titles.push_back(title);
+    publications.push_back(publication);
+    dates.push_back(date);
+    if (wordCount.size() < docs.size())
     {
-        output << itr.first << "^" << itr.second << "#" << std::endl; // Write each word count entry, formatted as 'word^count#'
+        wordCount.resize(docs.size(), 0); // Keeps the word count table covering every document
+        relativeWordCounts = nullptr;
     }
+    return docs.size() - 1;
 }
 
-// Reads and populates the index data from persistent storage
-void IndexHandler::readPersistence()
+// Returns the number of documents in the index
+int IndexHandler::getDocSize() const
+{
+    return file ? file->getDocCount() : docs.size();
+}
+
+// Writes the index to the binary persistence file
+void IndexHandler::createPersistence() const
 {
-    // Open a file stream for reading
-    std::ifstream input("persistence.txt");
+    if (file)
+    {
+        std::cout << "The index was read from " << PERSISTENCE_FILE << " and is already persisted." << std::endl;
+        return; // Rewriting the file would pull it out from under the mapping
+    }
+
+    // The file stores each dictionary sorted by key so it can be binary searched in place
+    IndexFile::Terms dictionaries[IndexFile::SECTION_COUNT];
+    auto collect = [](IndexFile::Terms &terms)
+    {
+        return [&terms](const std::string &key, const PostingList<DocId> &postings)
+        { terms.emplace_back(key, &postings); };
+    };
+    words.forEach(collect(dictionaries[IndexFile::WORDS])); // In-order traversal is already sorted
+    people.forEach(collect(dictionaries[IndexFile::PEOPLE]));
+    orgs.forEach(collect(dictionaries[IndexFile::ORGS]));
+    std::sort(dictionaries[IndexFile::PEOPLE].begin(), dictionaries[IndexFile::PEOPLE].end());
+    std::sort(dictionaries[IndexFile::ORGS].begin(), dictionaries[IndexFile::ORGS].end());
 
-    // Declare variables for parsing the file
-    std::string buffer, answer, node, id, freq, title, count, path;
+    // Position lists go in the same order as the words they belong to
+    std::vector<const PositionList *> wordPositions;
+    if (positional)
+    {
+        wordPositions.reserve(dictionaries[IndexFile::WORDS].size());
+        for (const auto &term : dictionaries[IndexFile::WORDS])
+        {
+            auto itr = positions.find(term.first);
+            wordPositions.push_back(itr != positions.end() ? &itr->second : nullptr);
+        }
+    }
 
-    // Check if the file stream is open
-    if (!input.is_open())
+    if (!IndexFile::write(PERSISTENCE_FILE, dictionaries, docs, titles, publications, dates, wordCount,
+                          stopWords.text(), positional ? &wordPositions : nullptr))
     {
         std::cerr << "Error! File could not be opened!" << std::endl;
-        exit(-1); // Exit if file could not be opened
+        exit(-1); // Exit if file could not be written
     }
+}
 
-    // Read the file line by line
-    while (getline(input, buffer))
+// Maps the persistence file and answers all further lookups from it
+void IndexHandler::readPersistence()
+{
+    std::shared_ptr<const IndexFile> opened = IndexFile::open(PERSISTENCE_FILE);
+    if (!opened)
     {
-        int index = 0; // Variable to keep track of the parsing position
+        std::cerr << "Error! File could not be opened!" << std::endl;
+        exit(-1); // Exit if file could not be opened
+    }
+
+    // Drop whatever was built in memory; the mapped file replaces it
+    words.makeEmpty();
+    people.clear();
+    orgs.clear();
+    docs.clear();
+    titles.clear();
+    publications.clear();
+    dates.clear();
+    wordCount.clear();
+    averageWordCount = 0;
+    positional = false;
+    positions = std::unordered_map<std::string, PositionList>();
+    stopWords.assign(opened->getStopWords());
+    relativeWordCounts = relativeLengths(opened->getWordCounts(), opened->getDocCount(), opened->getAverageWordCount());
+    file = opened;
+}
+
+// Reads the persistence file into a fresh index and hands it out as a shared, read-only snapshot
+std::shared_ptr<const IndexHandler> IndexHandler::openPersistence()
+{
+    std::shared_ptr<IndexHandler> index = std::make_shared<IndexHandler>();
+    index->readPersistence();
+    return index;
+}
+
+// Returns the number of unique words in the index
+int IndexHandler::returnSize() const
+{
+    return file ? file->getTermCount(IndexFile::WORDS) : words.getSize();
+}
+
 
-        // Iterate over characters in the line
-        for (size_t i = 0; i < buffer.length(); i++)
+// Merges the words, people, organizations, documents and word counts of another index into this one
+void IndexHandler::merge(const IndexHandler &other)
+{
+    // The other index's documents are appended, so its IDs are shifted past the ones already here
+    DocId offset = docs.size();
+    auto remap = [offset](DocId id)
+    { return id + offset; };
+
+    words.merge(other.words, remap);
+    people.merge(other.people, remap);
+    orgs.merge(other.orgs, remap);
+    docs.insert(docs.end(), other.docs.begin(), other.docs.end());
+    titles.insert(titles.end(), other.titles.begin(), other.titles.end());
+    publications.insert(publications.end(), other.publications.begin(), other.publications.end());
+    dates.insert(dates.end(), other.dates.begin(), other.dates.end());
+    for (size_t i = 0; i < other.wordCount.size(); i++)
+    {
+        addWordCount(offset + i, other.wordCount[i]);
+    }
+    if (other.positional)
+    {
+        positional = true;
+        for (const auto &entry : other.positions)
         {
-            if (buffer[i] == '/' && buffer[i + 1] == '/')
-            {
-                answer = buffer.substr(2, buffer.length()); // Extract the section identifier
-                break;
-            }
-            else if (buffer[i] == ':')
-            {
-                node = buffer.substr(index, i - index); // Extract node value
-                index = i + 1;
-            }
-            else if (buffer[i] == ',')
-            {
-                id = buffer.substr(index, i - index); // Extract ID value
-                index = i + 1;
-            }
-            else if (buffer[i] == ';')
-            {
-                freq = buffer.substr(index, i - index); // Extract frequency
-                index = i + 1;
-                int num = stoi(freq); // Convert frequency to integer
-                // Insert data into appropriate data structure based on section identifier
-                if (answer == "words")
-                    words.insert(node, id, num);
-                else if (answer == "people")
-                    people.insert(node, id, num);
-                else if (answer == "orgs")
-                    orgs.insert(node, id, num);
-            }
-            else if (buffer[i] == '^')
-            {
-                title = buffer.substr(index, i - index); // Extract title
-                index = i + 1;
-            }
-            else if (buffer[i] == '$')
-            {
-                path = buffer.substr(index, i - index); // Extract file path
-                docs.push_back(path);                   // Add file path to documents vector
-            }
-            else if (buffer[i] == '#')
-            {
-                count = buffer.substr(index, i - index); // Extract count
-                index = i + 1;
-                int num2 = stoi(count);  // Convert count to integer
-                wordCount[title] = num2; // Add word count to wordCount map
-            }
+            positions[entry.first].append(entry.second, offset); // Appended like the posting lists, so they line up
         }
     }
-    input.close(); // Close the file stream
 }
 
-// Returns the size of the words AVL tree
-int IndexHandler::returnSize()
+// Sorts and compacts the posting lists of all three containers, encodes the position lists and precomputes the
+// length statistics. The word counts go into the posting lists' block headers as well, where they bound the scores
+// for ranked retrieval
+void IndexHandler::finalize()
 {
-    return words.getSize(); // Returns the size of the AVL tree containing words
+    words.finalize(wordCount.data(), wordCount.size());
+    people.finalize(wordCount.data(), wordCount.size());
+    orgs.finalize(wordCount.data(), wordCount.size());
+    for (auto &entry : positions)
+    {
+        entry.second.finalize();
+    }
+
+    double totalWords = 0;
+    for (int count : wordCount)
+    {
+        totalWords += count;
+    }
+    averageWordCount = wordCount.empty() ? 0 : totalWords / wordCount.size();
+    relativeWordCounts = relativeLengths(wordCount.data(), wordCount.size(), averageWordCount);
 }
@@ -2,71 +2,151 @@
 #define INDEX_HANDLER_H
 
 // Including necessary header files
-#include "Hash.h"      // Include custom Hash table implementation
-#include "DSAvlTree.h" // Include custom AVL Tree implementation
-#include <algorithm>   // Standard library for various algorithms
-#include <string>      // Standard library for string handling
-#include <map>         // Standard library for map data structure
-#include <vector>      // Standard library for vector data structure
+#include "FlatHash.h"     // Include the open-addressing hash table
+#include "DSAvlTree.h"    // Include custom AVL Tree implementation
+#include "BPlusTree.h"    // Include the B+-tree alternative for the word dictionary
+#include "PostingList.h"  // Include posting list shared by both containers
+#include "PositionList.h" // Include word position lists for phrase queries
+#include "IndexFile.h"    // Include the binary persistence format
+#include "StopWords.h"    // Include the stopword list the index is built with
+#include <algorithm>      // Standard library for various algorithms
+#include <memory>         // Standard library for shared pointers
+#include <string>         // Standard library for string handling
+#include <unordered_map>  // Standard library for the word position table
+#include <vector>         // Standard library for vector data structure
 
 // Class definition for IndexHandler
 class IndexHandler
 {
 private:
-    // AVL Tree to store words. Maps string to string.
-    DSAvlTree<std::string, std::string> words;
+    // Ordered dictionary of words: an AVL tree, or a B+-tree when built with WORDS_BPLUS_TREE. Maps string to document IDs.
+#ifdef WORDS_BPLUS_TREE
+    BPlusTree<std::string, DocId> words;
+#else
+    DSAvlTree<std::string, DocId> words;
+#endif
 
-    // Hash tables for people and organizations. Maps string to string.
-    Hash<std::string, std::string> people;
-    Hash<std::string, std::string> orgs;
+    // Open-addressing hash tables for people and organizations. Maps string to document IDs.
+    FlatHash<std::string, DocId> people;
+    FlatHash<std::string, DocId> orgs;
 
-    // Vector to store document strings
+    // Document table indexed by document ID: file path, title, publication and publication date of each document
     std::vector<std::string> docs;
+    std::vector<std::string> titles;
+    std::vector<std::string> publications;
+    std::vector<std::string> dates;
+
+    // Word count of each document, indexed by document ID
+    std::vector<int> wordCount;
+
+    // Average of wordCount, computed by finalize() for the rankers
+    double averageWordCount = 0;
+
+    // Word count of each document relative to the average, computed once per snapshot (by finalize() or when the
+    // file is mapped) and shared by the scorers of every query processor; dropped whenever a word count changes
+    std::shared_ptr<const std::vector<float>> relativeWordCounts;
+
+    // Positions of each word, aligned with its posting list; only filled in once enablePositions() is called, so
+    // an index without positions pays for nothing but the empty table
+    bool positional = false;
+    std::unordered_map<std::string, PositionList> positions;
+
+    // Words left out of the index; persisted with it so queries leave out the same words
+    StopWords stopWords;
 
-    // Map to store word count. Maps string to an integer.
-    std::map<std::string, int> wordCount;
+    // Memory-mapped persistence file; when set, lookups are answered from it instead of the containers above
+    std::shared_ptr<const IndexFile> file;
 
 public:
     // Public member functions to interact with the IndexHandler
 
-    // Retrieves a map of words given a string
-    std::map<std::string, int> getWords(std::string);
+    // Retrieves a view of the posting list of a word (empty if the word is not indexed)
+    PostingView<DocId> getWords(const std::string &) const;
+
+    // Retrieves a view of the posting list of a person (empty if the person is not indexed)
+    PostingView<DocId> getPeople(const std::string &) const;
+
+    // Retrieves a view of the posting list of an organization (empty if the organization is not indexed)
+    PostingView<DocId> getOrgs(const std::string &) const;
+
+    // Retrieves the positions of a word, aligned with its posting list (empty if the word is not indexed or the
+    // index has no positions)
+    PositionView getPositions(const std::string &) const;
+
+    // Records word positions for the documents added from now on; must be called before any document is added
+    void enablePositions();
+
+    // Returns whether the index records word positions
+    bool hasPositions() const;
 
-    // Retrieves a map of people given a string
-    std::map<std::string, int> getPeople(std::string);
+    // Sets the stopwords the documents are indexed without, for queries to leave out as well
+    void setStopWords(const StopWords &);
 
-    // Retrieves a map of organizations given a string
-    std::map<std::string, int> getOrgs(std::string);
+    // Returns the stopwords the index was built without (the built-in list unless set)
+    const StopWords &getStopWords() const;
 
-    // Returns the count of a specific word
-    int getWordCount(std::string);
+    // Returns the word count of a specific document
+    int getWordCount(DocId) const;
 
-    // Adds words to the words AVL tree
-    void addWords(std::string, std::string);
+    // Returns the word counts of all documents as one array indexed by document ID
+    const int *getWordCounts() const;
+
+    // Returns the average word count of the indexed documents
+    double getAverageWordCount() const;
+
+    // Returns the word counts relative to the average, indexed by document ID (nullptr until the index is finalized)
+    std::shared_ptr<const std::vector<float>> getRelativeWordCounts() const;
+
+    // Returns the file path of a specific document
+    std::string getDocPath(DocId) const;
+
+    // Returns the title of a specific document
+    std::string getTitle(DocId) const;
+
+    // Returns the publication (site) of a specific document
+    std::string getPublication(DocId) const;
+
+    // Returns the publication date (YYYY-MM-DD) of a specific document
+    std::string getDate(DocId) const;
+
+    // Adds words to the words dictionary
+    void addWords(const std::string &, DocId);
+
+    // Records the position (token ordinal) of an occurrence of a word in a document; ignored without positions
+    void addPosition(const std::string &, DocId, uint32_t);
 
     // Adds people to the people hash table
-    void addPeople(std::string, std::string);
+    void addPeople(const std::string &, DocId);
 
     // Adds organizations to the orgs hash table
-    void addOrgs(std::string, std::string);
+    void addOrgs(const std::string &, DocId);
 
-    // Adds a document to the docs vector
-    void addDocument(std::string);
+    // Adds a document (file path, title, publication and date) to the document table and returns its ID
+    DocId addDocument(std::string, std::string, std::string = "", std::string = "");
 
-    // Add word count in the wordCount map
-    void addWordCount(std::string, int);
+    // Sets the word count of a document
+    void addWordCount(DocId, int);
 
     // Returns the size of the documents vector
-    int getDocSize();
+    int getDocSize() const;
 
-    // Function to create persistence
-    void createPersistence();
+    // Writes the index to the binary persistence file
+    void createPersistence() const;
 
-    // Function to read from persistence
+    // Maps the binary persistence file; lookups are then served from it without rebuilding the containers
     void readPersistence();
 
+    // Maps the binary persistence file into a new index that can be shared by every component
+    static std::shared_ptr<const IndexHandler> openPersistence();
+
     // Returns the size of words tree
-    int returnSize();
+    int returnSize() const;
+
+    // Folds a partial index (e.g. one built by a worker thread) into this one
+    void merge(const IndexHandler &);
+
+    // Sorts and compacts every posting list, encodes the position lists and computes the document length statistics once indexing is done
+    void finalize();
 };
 
 #endif
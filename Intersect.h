@@ -0,0 +1,247 @@
+#ifndef INTERSECT_H
+#define INTERSECT_H
+#include "PostingList.h"
+#include <algorithm>
+#include <cstddef>
+#if defined(__SSE2__)
+#include <emmintrin.h> // SSE2 intrinsics for the block kernel
+#endif
+
+// Intersection kernels over ascending, duplicate-free document ID arrays. Each kernel reports a match by calling
+// emit(i, j) with its position in both arrays, so callers can pick up frequencies from either side
+namespace Intersect
+{
+    // Lists whose sizes differ by more than this factor are intersected by galloping through the longer one
+    const size_t GALLOP_RATIO = 32;
+    // Lists whose sizes differ by more than this factor, but not by GALLOP_RATIO, are intersected by scanning the
+    // longer one SCAN_WIDTH IDs at a time
+    const size_t SCAN_RATIO = 4;
+    const size_t SCAN_WIDTH = 16;
+
+    // Returns the first position at or after lo whose ID is not less than target (n if there is none).
+    // Probes lo + 1, lo + 2, lo + 4, ... and then binary searches the last step, so it costs O(log distance)
+    inline size_t gallop(const DocId *ids, size_t lo, size_t n, DocId target)
+    {
+        size_t bound = 1;
+        while (lo + bound < n && ids[lo + bound] < target)
+        {
+            bound *= 2;
+        }
+        return std::lower_bound(ids + lo + bound / 2, ids + std::min(lo + bound + 1, n), target) - ids;
+    }
+
+    // Returns the first position at or after lo whose ID is greater than target (n if there is none), like gallop()
+    inline size_t gallopPast(const DocId *ids, size_t lo, size_t n, DocId target)
+    {
+        size_t bound = 1;
+        while (lo + bound < n && ids[lo + bound] <= target)
+        {
+            bound *= 2;
+        }
+        return std::upper_bound(ids + lo + bound / 2, ids + std::min(lo + bound + 1, n), target) - ids;
+    }
+
+    // Looks every ID of the short list up in the long one: O(small * log(large / small))
+    template <typename Emit>
+    void galloping(const DocId *small, size_t smallCount, const DocId *large, size_t largeCount, Emit &&emit)
+    {
+        size_t j = 0;
+        for (size_t i = 0; i < smallCount && j < largeCount; i++)
+        {
+            j = gallop(large, j, largeCount, small[i]);
+            if (j < largeCount && large[j] == small[i])
+            {
+                emit(i, j);
+                ++j;
+            }
+        }
+    }
+
+    // Linear merge of two lists from positions i and j onwards
+    template <typename Emit>
+    void merge(const DocId *a, size_t i, size_t aCount, const DocId *b, size_t j, size_t bCount, Emit &&emit)
+    {
+        while (i < aCount && j < bCount)
+        {
+            if (a[i] < b[j])
+            {
+                ++i;
+            }
+            else if (b[j] < a[i])
+            {
+                ++j;
+            }
+            else
+            {
+                emit(i, j);
+                ++i;
+                ++j;
+            }
+        }
+    }
+
+    // Merge that compares blocks of four IDs against four IDs at once: each block of a is compared with the
+    // four rotations of the block of b, and the block with the smaller last ID is skipped. Falls back to the
+    // linear merge for the tails, or entirely when SSE2 is not available
+    template <typename Emit>
+    void blocks(const DocId *a, size_t aCount, const DocId *b, size_t bCount, Emit &&emit)
+    {
+        size_t i = 0, j = 0;
+#if defined(__SSE2__)
+        while (i + 4 <= aCount && j + 4 <= bCount)
+        {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + j));
+            __m128i eq = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi32(va, vb),
+                             _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+                _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+                             _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(eq)); // Bit k is set if a[i + k] is somewhere in the b block
+            while (mask != 0)
+            {
+                size_t lane = __builtin_ctz(mask);
+                size_t k = 0;
+                while (b[j + k] != a[i + lane])
+                {
+                    ++k;
+                }
+                emit(i + lane, j + k);
+                mask &= mask - 1;
+            }
+            DocId aLast = a[i + 3], bLast = b[j + 3];
+            if (aLast <= bLast)
+            {
+                i += 4;
+            }
+            if (bLast <= aLast)
+            {
+                j += 4;
+            }
+        }
+#endif
+        merge(a, i, aCount, b, j, bCount, emit);
+    }
+
+    // Looks every ID of the short list up in the long one, skipping SCAN_WIDTH IDs of the long list at a time by
+    // their last ID and then comparing the ID with all SCAN_WIDTH of them at once (four SSE2 vectors), so there is
+    // a branch per skip instead of one per step of a gallop. Falls back to the linear merge for the tail of the
+    // long list
+    template <typename Emit>
+    void scanning(const DocId *small, size_t smallCount, const DocId *large, size_t largeCount, Emit &&emit)
+    {
+        size_t j = 0;
+        for (size_t i = 0; i < smallCount; i++)
+        {
+            const DocId target = small[i];
+            while (j + SCAN_WIDTH <= largeCount && large[j + SCAN_WIDTH - 1] < target)
+            {
+                j += SCAN_WIDTH;
+            }
+            if (j + SCAN_WIDTH > largeCount)
+            {
+                merge(small, i, smallCount, large, j, largeCount, emit);
+                return;
+            }
+#if defined(__SSE2__)
+            const __m128i key = _mm_set1_epi32(int(target));
+            const __m128i *run = reinterpret_cast<const __m128i *>(large + j);
+            __m128i eq = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi32(key, _mm_loadu_si128(run)), _mm_cmpeq_epi32(key, _mm_loadu_si128(run + 1))),
+                _mm_or_si128(_mm_cmpeq_epi32(key, _mm_loadu_si128(run + 2)), _mm_cmpeq_epi32(key, _mm_loadu_si128(run + 3))));
+            if (_mm_movemask_epi8(eq) != 0)
+#else
+            if (std::binary_search(large + j, large + j + SCAN_WIDTH, target))
+#endif
+            {
+                size_t k = j;
+                while (large[k] != target)
+                {
+                    ++k;
+                }
+                emit(i, k);
+            }
+        }
+    }
+
+    // Intersects two lists with the kernel that suits their sizes. Matches are reported as emit(i, j) with i
+    // indexing a and j indexing b, whichever list ends up driving the search
+    template <typename Emit>
+    void intersect(const DocId *a, size_t aCount, const DocId *b, size_t bCount, Emit &&emit)
+    {
+        if (aCount == 0 || bCount == 0)
+        {
+            return;
+        }
+        if (aCount * GALLOP_RATIO < bCount)
+        {
+            galloping(a, aCount, b, bCount, emit);
+        }
+        else if (bCount * GALLOP_RATIO < aCount)
+        {
+            galloping(b, bCount, a, aCount, [&emit](size_t j, size_t i)
+                      { emit(i, j); });
+        }
+        else if (aCount * SCAN_RATIO < bCount)
+        {
+            scanning(a, aCount, b, bCount, emit);
+        }
+        else if (bCount * SCAN_RATIO < aCount)
+        {
+            scanning(b, bCount, a, aCount, [&emit](size_t j, size_t i)
+                     { emit(i, j); });
+        }
+        else
+        {
+            blocks(a, aCount, b, bCount, emit);
+        }
+    }
+
+    // Intersects ascending candidates with a posting list. Matches are reported as emit(i, j) with i indexing the
+    // candidates and j the entry's position in the list. A plain list is intersected in place. A compressed list
+    // is decoded a whole block at a time into a buffer and intersected with the candidates by the kernels above:
+    // when the candidates are dense next to the list, a run of CHUNK blocks at a time, small enough to still be in
+    // cache when the kernel reads it; otherwise only the blocks holding a candidate, found by their headers. No
+    // block before the first candidate's or after the last one's is decoded
+    template <typename Emit>
+    void intersect(const DocId *candidates, size_t n, const PostingView<DocId> &list, Emit &&emit)
+    {
+        if (!list.compressed())
+        {
+            intersect(candidates, n, list.idData(), list.size(), emit);
+            return;
+        }
+        if (n == 0)
+        {
+            return;
+        }
+        const size_t CHUNK = 16;
+        DocId decoded[CHUNK * BlockCodec::BLOCK_SIZE];
+        const size_t run = n * GALLOP_RATIO >= list.size() ? CHUNK : 1;
+        // Blocks up to the last candidate's
+        const size_t blocks = std::min(list.findBlock(candidates[n - 1]) + 1, list.blockCount());
+        size_t k = 0, b = 0;
+        while (k < n)
+        {
+            b = list.findBlock(candidates[k], b);
+            if (b == list.blockCount())
+            {
+                break; // No candidate from k on is in the list
+            }
+            // Blocks b up to end; all but the last block of a list are full, so their entries stay contiguous
+            const size_t end = std::min(b + run, blocks);
+            size_t count = 0;
+            for (size_t block = b; block < end; block++)
+            {
+                count += list.decodeBlock(block, decoded + count, nullptr);
+            }
+            const size_t next = gallopPast(candidates, k, n, list.blockLast(end - 1));
+            const size_t first = b * BlockCodec::BLOCK_SIZE;
+            intersect(candidates + k, next - k, decoded, count, [&emit, k, first](size_t i, size_t j)
+                      { emit(k + i, first + j); });
+            k = next;
+            b = end;
+        }
+    }
+}
+#endif
@@ -0,0 +1,455 @@
+#ifndef MATCH_CURSOR_H
+#define MATCH_CURSOR_H
+#include "PostingCursor.h"
+#include "PositionList.h"
+#include "Scorer.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Cursors over the documents matching a query expression, in ascending document ID order. A term walks its posting
+// list, an AND leapfrogs its operands, an OR merges its operands with a heap and a phrase checks the positions of
+// its words in the documents that have all of them. Each cursor also scores its current
+// document by summing the scores of the terms that match it, so a query tree is matched and scored in one pass
+// without building the result list of any sub-expression
+class MatchCursor
+{
+public:
+    virtual ~MatchCursor() {}
+
+    // Whether the cursor has moved past the last matching document
+    virtual bool atEnd() const = 0;
+
+    // Current document; only valid while !atEnd()
+    virtual DocId value() const = 0;
+
+    // Moves to the next matching document
+    virtual void next() = 0;
+
+    // Moves to the first matching document not less than target; never moves backwards
+    virtual void advance(DocId target) = 0;
+
+    // Score of the current document, and how often the terms that match it occur in it
+    virtual double score() = 0;
+    virtual int freq() = 0;
+
+    // Upper bound of the number of matching documents, which orders the operands of an AND
+    virtual size_t cost() const = 0;
+};
+
+// A single term: its posting list, scored with the term's weight
+class TermMatch : public MatchCursor
+{
+private:
+    PostingCursor<DocId> cursor;
+    Scorer &scorer;
+    double weight; // The scorer's weight of the term
+
+public:
+    TermMatch(const PostingView<DocId> &list, Scorer &s) : cursor{list}, scorer{s}, weight{s.termWeight(list.size())} {}
+
+    bool atEnd() const override { return cursor.atEnd(); }
+    DocId value() const override { return cursor.value(); }
+    void next() override { cursor.next(); }
+    void advance(DocId target) override { cursor.advance(target); }
+
+    double score() override
+    {
+        scorer.setWeight(weight);
+        return scorer.score(cursor.value(), cursor.freq());
+    }
+    int freq() override { return cursor.freq(); }
+
+    size_t cost() const override { return cursor.size(); }
+};
+
+// Documents matching every operand and no excluded expression. The operands leapfrog from the cheapest one: each is
+// advanced to the lead's document, and the lead skips ahead to the first one that is past it. An AND without
+// operands matches nothing
+class AndMatch : public MatchCursor
+{
+private:
+    std::vector<std::unique_ptr<MatchCursor>> operands; // Cheapest first
+    std::vector<std::unique_ptr<MatchCursor>> excluded;
+    bool done; // Whether the lead or another operand has run out
+
+    // Whether an excluded expression matches candidate; candidates only ever grow, so the cursors only move forward
+    bool isExcluded(DocId candidate)
+    {
+        for (auto &cursor : excluded)
+        {
+            cursor->advance(candidate);
+            if (!cursor->atEnd() && cursor->value() == candidate)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Moves the lead from its current document to the first one that every operand and no excluded expression
+    // matches, with every operand on it
+    void settle()
+    {
+        MatchCursor &lead = *operands[0];
+        while (!lead.atEnd())
+        {
+            DocId candidate = lead.value();
+            size_t i = 1;
+            while (i < operands.size())
+            {
+                operands[i]->advance(candidate);
+                if (operands[i]->atEnd() || operands[i]->value() != candidate)
+                {
+                    break;
+                }
+                i++;
+            }
+            if (i < operands.size())
+            {
+                if (operands[i]->atEnd())
+                {
+                    break; // An operand has run out
+                }
+                lead.advance(operands[i]->value()); // Nothing before that document can be in operand i
+            }
+            else if (isExcluded(candidate))
+            {
+                lead.next();
+            }
+            else
+            {
+                return;
+            }
+        }
+        done = true;
+    }
+
+public:
+    AndMatch(std::vector<std::unique_ptr<MatchCursor>> o, std::vector<std::unique_ptr<MatchCursor>> e)
+        : operands{std::move(o)}, excluded{std::move(e)}, done{operands.empty()}
+    {
+        std::stable_sort(operands.begin(), operands.end(), [](const std::unique_ptr<MatchCursor> &a, const std::unique_ptr<MatchCursor> &b)
+                         { return a->cost() < b->cost(); });
+        if (!done)
+        {
+            settle();
+        }
+    }
+
+    bool atEnd() const override { return done; }
+    DocId value() const override { return operands[0]->value(); }
+
+    void next() override
+    {
+        operands[0]->next();
+        settle();
+    }
+
+    void advance(DocId target) override
+    {
+        if (done || !(operands[0]->value() < target))
+        {
+            return;
+        }
+        operands[0]->advance(target);
+        settle();
+    }
+
+    double score() override
+    {
+        double total = 0;
+        for (auto &operand : operands)
+        {
+            total += operand->score();
+        }
+        return total;
+    }
+
+    int freq() override
+    {
+        int total = 0;
+        for (auto &operand : operands)
+        {
+            total += operand->freq();
+        }
+        return total;
+    }
+
+    size_t cost() const override { return operands.empty() ? 0 : operands[0]->cost(); }
+};
+
+// Documents matching any operand: a k-way merge. The operands past the current document sit in a min-heap on their
+// documents, and the ones on it are kept aside, so moving on costs O(log k) per posting passed and scoring the
+// current document only touches the operands that match it
+class OrMatch : public MatchCursor
+{
+private:
+    std::vector<std::unique_ptr<MatchCursor>> operands;
+    std::vector<MatchCursor *> heap;    // Operands past the current document, with the earliest on top
+    std::vector<MatchCursor *> current; // Operands on the current document; empty once every operand has run out
+
+    // Heap order: the operand on the earlier document comes first
+    static bool later(const MatchCursor *a, const MatchCursor *b)
+    {
+        return b->value() < a->value();
+    }
+
+    // Returns the operands in current to the heap and takes out all the ones on the earliest document
+    void settle()
+    {
+        for (MatchCursor *operand : current)
+        {
+            if (!operand->atEnd())
+            {
+                heap.push_back(operand);
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+        current.clear();
+        while (!heap.empty() && (current.empty() || heap.front()->value() == current[0]->value()))
+        {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            current.push_back(heap.back());
+            heap.pop_back();
+        }
+    }
+
+public:
+    explicit OrMatch(std::vector<std::unique_ptr<MatchCursor>> o) : operands{std::move(o)}
+    {
+        heap.reserve(operands.size());
+        for (auto &operand : operands)
+        {
+            current.push_back(operand.get());
+        }
+        settle();
+    }
+
+    bool atEnd() const override { return current.empty(); }
+    DocId value() const override { return current[0]->value(); }
+
+    void next() override
+    {
+        for (MatchCursor *operand : current)
+        {
+            operand->next();
+        }
+        settle();
+    }
+
+    void advance(DocId target) override
+    {
+        if (atEnd() || !(value() < target))
+        {
+            return;
+        }
+        for (MatchCursor *operand : current)
+        {
+            operand->advance(target);
+        }
+        while (!heap.empty() && heap.front()->value() < target) // Operands behind target catch up too
+        {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            heap.back()->advance(target);
+            current.push_back(heap.back());
+            heap.pop_back();
+        }
+        settle();
+    }
+
+    double score() override
+    {
+        double total = 0;
+        for (MatchCursor *operand : current)
+        {
+            total += operand->score();
+        }
+        return total;
+    }
+
+    int freq() override
+    {
+        int total = 0;
+        for (MatchCursor *operand : current)
+        {
+            total += operand->freq();
+        }
+        return total;
+    }
+
+    size_t cost() const override
+    {
+        size_t total = 0;
+        for (auto &operand : operands)
+        {
+            total += operand->cost();
+        }
+        return total;
+    }
+};
+
+// Documents in which words occur as a phrase: each word its offset in the phrase past the previous one, plus up to
+// slop extra positions in between. Candidates come from leapfrogging the words' posting lists like an AND, and only
+// their positions are decoded and checked. The score sums the words' scores; freq() is the number of times the
+// phrase occurs, counted by the positions it ends at. A word whose positions do not line up with its postings (from
+// an index built without positions) matches nothing
+class PhraseMatch : public MatchCursor
+{
+public:
+    // One word of the phrase: its posting list, its positions and its position in the phrase (which skips the
+    // stopwords that were not indexed)
+    struct Word
+    {
+        PostingView<DocId> list;
+        PositionView positions;
+        uint32_t offset;
+    };
+
+private:
+    struct Term
+    {
+        PostingCursor<DocId> cursor;
+        PositionView positions;
+        uint32_t offset;
+        double weight;               // The scorer's weight of the word
+        std::vector<uint32_t> found; // Positions of the word in the current candidate
+    };
+    std::vector<Term> terms;         // In phrase order
+    std::vector<size_t> order;       // Indexes of terms, rarest first
+    std::vector<uint32_t> ends;      // Scratch: positions of a word that end a partial match
+    std::vector<uint32_t> following; // Scratch: the same for the following word
+    Scorer &scorer;
+    uint32_t slop;
+    int occurrences; // Of the phrase in the current document
+    bool done;
+
+    // Number of times the phrase occurs in the document every cursor is on. Going through the words in phrase
+    // order, a position of a word ends a partial match if a partial match of the previous word ends between
+    // offset and offset + slop positions before it; both lists are ascending, so each word takes one merge pass
+    int countOccurrences()
+    {
+        for (Term &term : terms)
+        {
+            term.positions.get(term.cursor.index(), term.found);
+        }
+        ends = terms[0].found;
+        for (size_t t = 1; t < terms.size() && !ends.empty(); t++)
+        {
+            const uint64_t gap = terms[t].offset - terms[t - 1].offset;
+            following.clear();
+            size_t i = 0;
+            for (uint32_t q : terms[t].found)
+            {
+                while (i < ends.size() && ends[i] + gap + slop < q)
+                {
+                    i++;
+                }
+                if (i == ends.size())
+                {
+                    break;
+                }
+                if (ends[i] + gap <= q)
+                {
+                    following.push_back(q);
+                }
+            }
+            ends.swap(following);
+        }
+        return ends.size();
+    }
+
+    // Moves the lead from its current document to the first one that holds the phrase, with every cursor on it
+    void settle()
+    {
+        PostingCursor<DocId> &lead = terms[order[0]].cursor;
+        while (!lead.atEnd())
+        {
+            DocId candidate = lead.value();
+            size_t i = 1;
+            while (i < order.size())
+            {
+                PostingCursor<DocId> &cursor = terms[order[i]].cursor;
+                cursor.advance(candidate);
+                if (cursor.atEnd() || cursor.value() != candidate)
+                {
+                    break;
+                }
+                i++;
+            }
+            if (i < order.size())
+            {
+                if (terms[order[i]].cursor.atEnd())
+                {
+                    break; // A word has run out
+                }
+                lead.advance(terms[order[i]].cursor.value());
+            }
+            else if ((occurrences = countOccurrences()) > 0)
+            {
+                return;
+            }
+            else
+            {
+                lead.next(); // All the words, but not as the phrase
+            }
+        }
+        done = true;
+    }
+
+public:
+    // words are in phrase order, with ascending offsets
+    PhraseMatch(const std::vector<Word> &words, uint32_t s, Scorer &sc) : scorer{sc}, slop{s}, occurrences{0}, done{words.empty()}
+    {
+        terms.reserve(words.size());
+        for (const Word &word : words)
+        {
+            terms.push_back(Term{PostingCursor<DocId>(word.list), word.positions, word.offset, sc.termWeight(word.list.size()), {}});
+            order.push_back(order.size());
+            done = done || word.positions.size() != word.list.size();
+        }
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b)
+                         { return terms[a].cursor.size() < terms[b].cursor.size(); });
+        if (!done)
+        {
+            settle();
+        }
+    }
+
+    bool atEnd() const override { return done; }
+    DocId value() const override { return terms[order[0]].cursor.value(); }
+
+    void next() override
+    {
+        terms[order[0]].cursor.next();
+        settle();
+    }
+
+    void advance(DocId target) override
+    {
+        if (done || !(value() < target))
+        {
+            return;
+        }
+        terms[order[0]].cursor.advance(target);
+        settle();
+    }
+
+    double score() override
+    {
+        double total = 0;
+        for (Term &term : terms)
+        {
+            scorer.setWeight(term.weight);
+            total += scorer.score(term.cursor.value(), term.cursor.freq());
+        }
+        return total;
+    }
+
+    int freq() override { return occurrences; }
+
+    size_t cost() const override { return terms.empty() ? 0 : terms[order[0]].cursor.size(); }
+};
+#endif
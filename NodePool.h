@@ -0,0 +1,124 @@
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Allocation policies for the nodes of DSAvlTree and Hash. A policy is a class template over the node type
+// with create(args...) to construct a node, destroy(node) to destroy one, and release() to give back all node
+// memory once every node has been destroyed.
+
+// Bump-pointer pool: nodes are carved out of blocks of BLOCK_SIZE slots, one after the other, so building a
+// tree or table costs one heap allocation per block instead of one per node, and neighbouring nodes share
+// cache lines. Destroyed nodes go on a free list and are reused by the next create. release() frees every
+// block at once. A pool belongs to one container: copies start with no blocks, moves take the blocks along.
+template <typename T>
+class NodePool
+{
+private:
+    static constexpr size_t BLOCK_SIZE = 256; // Nodes per block
+
+    // Storage for one node, or the link to the next free slot once the node is destroyed
+    union Slot
+    {
+        Slot *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> blocks; // Every block allocated so far; the last one is being filled
+    size_t used;                                 // Slots handed out from the last block
+    Slot *freeList;                              // Slots of destroyed nodes
+
+public:
+    NodePool() : used{BLOCK_SIZE}, freeList{nullptr} {}
+
+    NodePool(const NodePool &) : NodePool() {}
+
+    NodePool(NodePool &&rhs) noexcept : blocks{std::move(rhs.blocks)}, used{rhs.used}, freeList{rhs.freeList}
+    {
+        rhs.blocks.clear();
+        rhs.used = BLOCK_SIZE;
+        rhs.freeList = nullptr;
+    }
+
+    NodePool &operator=(const NodePool &)
+    {
+        return *this; // Nodes stay in the pool that created them
+    }
+
+    // The pool must not have live nodes, as its blocks are freed
+    NodePool &operator=(NodePool &&rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            blocks = std::move(rhs.blocks);
+            used = rhs.used;
+            freeList = rhs.freeList;
+            rhs.blocks.clear();
+            rhs.used = BLOCK_SIZE;
+            rhs.freeList = nullptr;
+        }
+        return *this;
+    }
+
+    // Constructs a node from args in the next free slot
+    template <typename... Args>
+    T *create(Args &&...args)
+    {
+        Slot *slot;
+        if (freeList != nullptr)
+        {
+            slot = freeList;
+            freeList = freeList->next;
+        }
+        else
+        {
+            if (used == BLOCK_SIZE)
+            {
+                blocks.emplace_back(new Slot[BLOCK_SIZE]);
+                used = 0;
+            }
+            slot = &blocks.back()[used++];
+        }
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+
+    // Destroys a node created by this pool and keeps its slot for reuse
+    void destroy(T *node)
+    {
+        node->~T();
+        Slot *slot = reinterpret_cast<Slot *>(node);
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+    // Frees every block in one go; all nodes must have been destroyed
+    void release()
+    {
+        blocks.clear();
+        used = BLOCK_SIZE;
+        freeList = nullptr;
+    }
+};
+
+// Policy that allocates every node on its own with new and delete, as the containers used to
+template <typename T>
+class HeapAllocator
+{
+public:
+    template <typename... Args>
+    T *create(Args &&...args)
+    {
+        return new T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T *node)
+    {
+        delete node;
+    }
+
+    void release() {}
+};
+#endif
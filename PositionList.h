@@ -0,0 +1,230 @@
+#ifndef POSITION_LIST_H
+#define POSITION_LIST_H
+#include "BlockCodec.h"
+#include "PostingList.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Positions of a word in the documents of its posting list: the i-th run of positions belongs to the i-th
+// document of the list. A position is the token's ordinal in the document's text, stopwords included, so that a
+// phrase keeps its gaps where stopwords were left out.
+//
+// Encoded lists are stored as one run of bytes:
+//   uint32 offset[blockCount]  where the run of the first document of each block of BlockCodec::BLOCK_SIZE
+//                              documents starts, in bytes from the start of the list
+//   runs                       per document: its byte length, then its positions as gaps (the first one from 0)
+// with every number a varint (7 bits per byte, least significant group first, high bit set on all but the last
+// byte). Offsets are in native byte order, like the block headers. Finding a document's run skips at most the
+// runs of the 127 documents before it in its block by their lengths, without decoding them
+namespace PositionCodec
+{
+    // Appends v to out as a varint
+    inline void appendVarint(std::vector<uint8_t> &out, uint32_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back(uint8_t(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(uint8_t(v));
+    }
+
+    // Reads the varint at p and moves p past it
+    inline uint32_t readVarint(const uint8_t *&p)
+    {
+        uint32_t v = 0;
+        for (unsigned shift = 0;; shift += 7)
+        {
+            uint8_t byte = *p++;
+            v |= uint32_t(byte & 0x7f) << shift;
+            if (byte < 0x80)
+            {
+                return v;
+            }
+        }
+    }
+
+    // Appends the encoding of count runs of ascending positions to out; run r is positions[starts[r]] up to
+    // positions[starts[r + 1]] (or the end of positions for the last run)
+    inline void encode(const uint32_t *starts, size_t count, const uint32_t *positions, size_t positionCount, std::vector<uint8_t> &out)
+    {
+        const size_t start = out.size();
+        out.resize(start + BlockCodec::blockCount(count) * sizeof(uint32_t)); // Filled in as the blocks begin
+        std::vector<uint8_t> run;
+        for (size_t r = 0; r < count; r++)
+        {
+            if (r % BlockCodec::BLOCK_SIZE == 0)
+            {
+                uint32_t offset = uint32_t(out.size() - start);
+                std::memcpy(out.data() + start + r / BlockCodec::BLOCK_SIZE * sizeof(uint32_t), &offset, sizeof(offset));
+            }
+            run.clear();
+            uint32_t previous = 0;
+            for (size_t k = starts[r]; k < (r + 1 < count ? starts[r + 1] : positionCount); k++)
+            {
+                appendVarint(run, positions[k] - previous);
+                previous = positions[k];
+            }
+            appendVarint(out, uint32_t(run.size()));
+            out.insert(out.end(), run.begin(), run.end());
+        }
+    }
+}
+
+// Read-only view of an encoded position list stored elsewhere (a PositionList or a memory-mapped index file).
+// A default-constructed view is empty, which is how lookups report a word without positions
+class PositionView
+{
+private:
+    const uint8_t *data; // The encoded list
+    size_t bytes;        // Number of bytes at data
+    size_t count;        // Number of documents
+
+public:
+    PositionView() : data{nullptr}, bytes{0}, count{0} {}
+    PositionView(const uint8_t *d, size_t b, size_t n) : data{d}, bytes{b}, count{n} {}
+
+    // Number of documents, the same as the size of the word's posting list
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Bytes taken by the encoded list
+    size_t packedBytes() const { return bytes; }
+    const uint8_t *packedData() const { return data; }
+
+    // Replaces the contents of out with the positions of the i-th document, in ascending order
+    void get(size_t i, std::vector<uint32_t> &out) const
+    {
+        out.clear();
+        uint32_t offset;
+        std::memcpy(&offset, data + i / BlockCodec::BLOCK_SIZE * sizeof(uint32_t), sizeof(offset));
+        const uint8_t *p = data + offset;
+        for (size_t skip = i % BlockCodec::BLOCK_SIZE; skip > 0; skip--)
+        {
+            uint32_t length = PositionCodec::readVarint(p);
+            p += length;
+        }
+        uint32_t length = PositionCodec::readVarint(p);
+        const uint8_t *end = p + length;
+        uint32_t position = 0;
+        while (p < end)
+        {
+            position += PositionCodec::readVarint(p);
+            out.push_back(position);
+        }
+    }
+};
+
+// Positions of one word, built while its documents are indexed (in ascending document ID order, as IndexHandler
+// hands the IDs out) and encoded by finalize(). Adding to a finalized list decodes it again first, like PostingList
+class PositionList
+{
+private:
+    std::vector<uint32_t> starts;    // Index in positions of each document's first position
+    std::vector<uint32_t> positions; // Positions of every document, one run after the other
+    std::vector<uint8_t> packed;     // The encoded list once finalized; starts and positions are then empty
+    size_t count;                    // Number of documents
+    DocId last;                      // Document of the last run
+
+    // Decodes a finalized list back into starts and positions so that more documents can be added to it
+    __attribute__((noinline)) void unpack()
+    {
+        PositionView packedView = view();
+        std::vector<uint32_t> run;
+        starts.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            starts.push_back(positions.size());
+            packedView.get(i, run);
+            positions.insert(positions.end(), run.begin(), run.end());
+        }
+        packed = std::vector<uint8_t>();
+    }
+
+public:
+    PositionList() : count{0}, last{0} {}
+
+    // Records an occurrence of the word at the given position of document id; positions arrive in ascending
+    // order within a document
+    void add(DocId id, uint32_t position)
+    {
+        if (!packed.empty())
+        {
+            unpack();
+        }
+        if (count == 0 || id != last)
+        {
+            starts.push_back(positions.size());
+            last = id;
+            count++;
+        }
+        positions.push_back(position);
+    }
+
+    // Appends the runs of another list, finalized or not, with its document IDs shifted by offset (the way
+    // IndexHandler::merge appends a partial index)
+    void append(const PositionList &other, DocId offset)
+    {
+        if (!packed.empty())
+        {
+            unpack();
+        }
+        if (!other.packed.empty())
+        {
+            PositionView otherView = other.view();
+            std::vector<uint32_t> run;
+            for (size_t i = 0; i < other.count; i++)
+            {
+                starts.push_back(positions.size());
+                otherView.get(i, run);
+                positions.insert(positions.end(), run.begin(), run.end());
+            }
+        }
+        else
+        {
+            for (uint32_t start : other.starts)
+            {
+                starts.push_back(positions.size() + start);
+            }
+            positions.insert(positions.end(), other.positions.begin(), other.positions.end());
+        }
+        if (other.count > 0)
+        {
+            last = other.last + offset;
+            count += other.count;
+        }
+    }
+
+    // Encodes the list and releases the building arrays
+    void finalize()
+    {
+        if (count == 0 || !packed.empty())
+        {
+            return;
+        }
+        encode(packed);
+        packed.shrink_to_fit();
+        starts = std::vector<uint32_t>();
+        positions = std::vector<uint32_t>();
+    }
+
+    // Appends the encoded list to out, whether or not it has been finalized
+    void encode(std::vector<uint8_t> &out) const
+    {
+        if (!packed.empty())
+        {
+            out.insert(out.end(), packed.begin(), packed.end());
+            return;
+        }
+        PositionCodec::encode(starts.data(), count, positions.data(), positions.size(), out);
+    }
+
+    // Number of documents
+    size_t size() const { return count; }
+
+    // View of the list; empty until the list is finalized
+    PositionView view() const { return packed.empty() ? PositionView() : PositionView(packed.data(), packed.size(), count); }
+};
+#endif
@@ -0,0 +1,125 @@
+#ifndef POSTING_CURSOR_H
+#define POSTING_CURSOR_H
+#include "PostingList.h"
+#include <algorithm>
+#include <cstddef>
+
+// Forward-only cursor over a posting list, plain or block-compressed. The last value of every block serves as skip
+// data: advance() passes over whole blocks by looking at those values alone and only decodes the block it lands
+// in, so jumping over a long stretch of a common term costs O(log distance) instead of a scan. A block's values
+// are decoded the first time one of them is looked at and its frequencies the first time one of those is asked
+// for; plain lists are read in place
+template <typename Value>
+class PostingCursor
+{
+private:
+    PostingView<Value> list;
+    size_t block;                          // Current block, list.blockCount() once the cursor is past the end
+    size_t position;                       // Current entry within the block
+    size_t length;                         // Number of entries in the current block
+    mutable const Value *values;           // Values of the current block, nullptr until decoded
+    const int *freqs;                      // Frequencies of the current block, nullptr until asked for
+    mutable Value valueBuffer[BlockCodec::BLOCK_SIZE]; // Decoded values of a compressed block
+    int freqBuffer[BlockCodec::BLOCK_SIZE];            // Decoded frequencies of a compressed block
+
+    // Moves to the first entry of block b, or past the end if there is no such block, without decoding it
+    void load(size_t b)
+    {
+        block = std::min(b, list.blockCount());
+        position = 0;
+        length = atEnd() ? 0 : BlockCodec::blockLength(list.size(), block);
+        values = nullptr;
+        freqs = nullptr;
+    }
+
+    // Values of the current block, decoding it if it has not been
+    const Value *blockData() const
+    {
+        if (values == nullptr)
+        {
+            values = list.blockIds(block, valueBuffer);
+        }
+        return values;
+    }
+
+public:
+    explicit PostingCursor(const PostingView<Value> &l) : list{l} { load(0); }
+
+    // Copies point into their own buffers, not the original's
+    PostingCursor(const PostingCursor &other) { *this = other; }
+    PostingCursor &operator=(const PostingCursor &other)
+    {
+        list = other.list;
+        block = other.block;
+        position = other.position;
+        length = other.length;
+        std::copy(other.valueBuffer, other.valueBuffer + BlockCodec::BLOCK_SIZE, valueBuffer);
+        std::copy(other.freqBuffer, other.freqBuffer + BlockCodec::BLOCK_SIZE, freqBuffer);
+        values = other.values == other.valueBuffer ? valueBuffer : other.values;
+        freqs = other.freqs == other.freqBuffer ? freqBuffer : other.freqs;
+        return *this;
+    }
+
+    // Whether the cursor has moved past the last entry
+    bool atEnd() const { return block == list.blockCount(); }
+
+    // Value and frequency of the current entry; only valid while !atEnd()
+    const Value &value() const { return blockData()[position]; }
+    int freq()
+    {
+        if (freqs == nullptr)
+        {
+            freqs = list.blockFreqs(block, freqBuffer);
+        }
+        return freqs[position];
+    }
+
+    // Number of entries in the whole list
+    size_t size() const { return list.size(); }
+
+    // The list being walked and the block the cursor is in, for looking at block headers ahead of the cursor
+    const PostingView<Value> &view() const { return list; }
+    size_t currentBlock() const { return block; }
+
+    // Ordinal of the current entry in the whole list, which lines up with per-entry data stored beside it
+    size_t index() const { return block * BlockCodec::BLOCK_SIZE + position; }
+
+    // Moves to the next entry
+    void next()
+    {
+        if (++position == length)
+        {
+            load(block + 1);
+        }
+    }
+
+    // Moves to the first entry whose value is not less than target; never moves backwards
+    void advance(const Value &target)
+    {
+        if (atEnd())
+        {
+            return;
+        }
+        if (list.blockLast(block) < target) // Skip to the block that can hold target without decoding this one
+        {
+            load(list.findBlock(target, block + 1));
+            if (atEnd())
+            {
+                return;
+            }
+        }
+        const Value *data = blockData();
+        if (!(data[position] < target))
+        {
+            return;
+        }
+        // Gallop from the current entry: targets are usually close by
+        size_t bound = 1;
+        while (position + bound < length && data[position + bound] < target)
+        {
+            bound *= 2;
+        }
+        position = std::lower_bound(data + position + bound / 2, data + std::min(position + bound + 1, length), target) - data;
+    }
+};
+#endif
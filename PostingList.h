@@ -0,0 +1,477 @@
+#ifndef POSTING_LIST_H
+#define POSTING_LIST_H
+#include "BlockCodec.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Dense document identifier handed out by IndexHandler::addDocument
+typedef uint32_t DocId;
+
+// Read-only view of a sorted posting list stored elsewhere (a PostingList or a memory-mapped index file).
+// A default-constructed view is empty, which is how lookups report a key that is not indexed.
+//
+// The list is either plain (parallel arrays of values and frequencies) or block-compressed (see BlockCodec.h),
+// which is how finalized and persisted DocId lists are stored. Both kinds are read block by block through
+// blockCount(), blockLast(), blockSeek() and decodeBlock(); the plain arrays are only there for plain lists
+template <typename Value>
+class PostingView
+{
+private:
+    const Value *ids;      // Plain lists: values in ascending order
+    const int *freqs;      // Plain lists: frequency of ids[i] is freqs[i]
+    const uint8_t *packed; // Compressed lists: headers and payload, nullptr for plain lists
+    size_t packedSize;     // Compressed lists: number of bytes at packed
+    size_t count;          // Number of entries
+
+public:
+    PostingView() : ids{nullptr}, freqs{nullptr}, packed{nullptr}, packedSize{0}, count{0} {}
+    PostingView(const Value *i, const int *f, size_t n) : ids{i}, freqs{f}, packed{nullptr}, packedSize{0}, count{n} {}
+    PostingView(const uint8_t *p, size_t bytes, size_t n) : ids{nullptr}, freqs{nullptr}, packed{p}, packedSize{bytes}, count{n} {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Whether the list is block-compressed rather than plain
+    bool compressed() const { return packed != nullptr; }
+
+    // Number of blocks of BlockCodec::BLOCK_SIZE entries (plain lists are split the same way)
+    size_t blockCount() const { return BlockCodec::blockCount(count); }
+
+    // Largest value of block b
+    Value blockLast(size_t b) const
+    {
+        if constexpr (std::is_same<Value, uint32_t>::value) // Only DocId lists are ever compressed
+        {
+            if (packed != nullptr)
+            {
+                return BlockCodec::lastId(packed, b);
+            }
+        }
+        return ids[std::min(count, (b + 1) * BlockCodec::BLOCK_SIZE) - 1];
+    }
+
+    // Largest frequency in block b and fewest words of a document in it (0 if unknown), which bound the score of
+    // any entry in the block. Compressed lists store both in the block headers; plain lists know no lengths and
+    // scan the block's frequencies
+    int blockMaxFreq(size_t b) const
+    {
+        if constexpr (std::is_same<Value, uint32_t>::value)
+        {
+            if (packed != nullptr)
+            {
+                return int(BlockCodec::maxFreq(packed, b));
+            }
+        }
+        const int *first = freqs + b * BlockCodec::BLOCK_SIZE;
+        return *std::max_element(first, first + BlockCodec::blockLength(count, b));
+    }
+    int blockMinLength(size_t b) const
+    {
+        if constexpr (std::is_same<Value, uint32_t>::value)
+        {
+            if (packed != nullptr)
+            {
+                return int(BlockCodec::minLength(packed, b));
+            }
+        }
+        return 0;
+    }
+
+    // First block at or after block from whose largest value is not less than v (blockCount() if there is none).
+    // Gallops over the block headers, so skipping far ahead costs O(log distance)
+    size_t findBlock(const Value &v, size_t from = 0) const
+    {
+        const size_t blocks = blockCount();
+        size_t bound = 1;
+        while (from + bound < blocks && blockLast(from + bound) < v)
+        {
+            bound *= 2;
+        }
+        size_t lo = from + bound / 2, hi = std::min(from + bound + 1, blocks);
+        while (lo < hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            if (blockLast(mid) < v)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    // First position at or after from within block b whose value is not less than v (the block's length if there
+    // is none). Compressed blocks are searched in place, without decoding them
+    size_t blockSeek(size_t b, const Value &v, size_t from = 0) const
+    {
+        if constexpr (std::is_same<Value, uint32_t>::value)
+        {
+            if (packed != nullptr)
+            {
+                return packedBlock(b).seek(v, from);
+            }
+        }
+        const Value *first = ids + b * BlockCodec::BLOCK_SIZE;
+        return std::lower_bound(first + from, first + BlockCodec::blockLength(count, b), v) - first;
+    }
+
+    // Value and frequency of the k-th entry of block b
+    Value blockId(size_t b, size_t k) const
+    {
+        if constexpr (std::is_same<Value, uint32_t>::value)
+        {
+            if (packed != nullptr)
+            {
+                return packedBlock(b).id(k);
+            }
+        }
+        return ids[b * BlockCodec::BLOCK_SIZE + k];
+    }
+    int blockFreq(size_t b, size_t k) const
+    {
+        if constexpr (std::is_same<Value, uint32_t>::value)
+        {
+            if (packed != nullptr)
+            {
+                return packedBlock(b).freq(k);
+            }
+        }
+        return freqs[b * BlockCodec::BLOCK_SIZE + k];
+    }
+
+    // Writes the values of block b to out (BLOCK_SIZE entries at most) and, unless outFreqs is nullptr, their
+    // frequencies; returns the number of entries in the block
+    size_t decodeBlock(size_t b, Value *out, int *outFreqs) const
+    {
+        if constexpr (std::is_same<Value, uint32_t>::value)
+        {
+            if (packed != nullptr)
+            {
+                if (outFreqs != nullptr)
+                {
+                    BlockCodec::decodeFreqs(packed, packedSize, count, b, outFreqs);
+                }
+                return BlockCodec::decodeIds(packed, packedSize, count, b, out);
+            }
+        }
+        const size_t first = b * BlockCodec::BLOCK_SIZE, length = BlockCodec::blockLength(count, b);
+        std::copy(ids + first, ids + first + length, out);
+        if (outFreqs != nullptr)
+        {
+            std::copy(freqs + first, freqs + first + length, outFreqs);
+        }
+        return length;
+    }
+
+    // Writes the frequencies of block b to out, like decodeBlock(); returns the number of entries in the block
+    size_t decodeFreqs(size_t b, int *out) const
+    {
+        if constexpr (std::is_same<Value, uint32_t>::value)
+        {
+            if (packed != nullptr)
+            {
+                return BlockCodec::decodeFreqs(packed, packedSize, count, b, out);
+            }
+        }
+        const size_t first = b * BlockCodec::BLOCK_SIZE, length = BlockCodec::blockLength(count, b);
+        std::copy(freqs + first, freqs + first + length, out);
+        return length;
+    }
+
+    // The values of block b: read in place from a plain list, decoded into buffer (BLOCK_SIZE entries) from a
+    // compressed one
+    const Value *blockIds(size_t b, Value *buffer) const
+    {
+        if (packed == nullptr)
+        {
+            return ids + b * BlockCodec::BLOCK_SIZE;
+        }
+        decodeBlock(b, buffer, nullptr);
+        return buffer;
+    }
+
+    // The frequencies of block b, like blockIds()
+    const int *blockFreqs(size_t b, int *buffer) const
+    {
+        if (packed == nullptr)
+        {
+            return freqs + b * BlockCodec::BLOCK_SIZE;
+        }
+        decodeFreqs(b, buffer);
+        return buffer;
+    }
+
+    // Calls f(value, frequency) for every entry, in ascending order
+    template <typename F>
+    void forEach(F f) const
+    {
+        if (packed == nullptr)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                f(ids[i], freqs[i]);
+            }
+            return;
+        }
+        Value blockIds[BlockCodec::BLOCK_SIZE];
+        int blockFreqs[BlockCodec::BLOCK_SIZE];
+        for (size_t b = 0; b < blockCount(); b++)
+        {
+            size_t length = decodeBlock(b, blockIds, blockFreqs);
+            for (size_t i = 0; i < length; i++)
+            {
+                f(blockIds[i], blockFreqs[i]);
+            }
+        }
+    }
+
+    // Returns the frequency of v, or 0 if v is not in the list
+    int getFrequency(const Value &v) const
+    {
+        if (packed != nullptr) // Only the block that can hold v is searched
+        {
+            size_t b = findBlock(v);
+            if (b == blockCount())
+            {
+                return 0;
+            }
+            size_t k = blockSeek(b, v);
+            return k == BlockCodec::blockLength(count, b) || v < blockId(b, k) ? 0 : blockFreq(b, k);
+        }
+        const Value *itr = std::lower_bound(ids, ids + count, v);
+        if (itr == ids + count || v < *itr)
+        {
+            return 0;
+        }
+        return freqs[itr - ids];
+    }
+
+    // Plain lists only: value and frequency of the i-th entry
+    const Value &getId(size_t i) const { return ids[i]; }
+    int getFreq(size_t i) const { return freqs[i]; }
+
+    // Plain lists only: contiguous arrays backing the view, for linear scans
+    const Value *idData() const { return ids; }
+    const int *freqData() const { return freqs; }
+
+    // Compressed lists only: the encoded bytes
+    const uint8_t *packedData() const { return packed; }
+    size_t packedBytes() const { return packedSize; }
+
+    // Compressed lists only: block b, opened for reading single entries in place
+    BlockCodec::Block packedBlock(size_t b) const { return BlockCodec::block(packed, packedSize, count, b); }
+};
+
+// Template class for a compact posting list: sorted values (e.g. document IDs) with a parallel array of frequencies.
+// Lists of document IDs are block-compressed by finalize() (see BlockCodec.h); the element accessors below are
+// for plain lists, while size(), getFrequency(), forEach() and view() work on both, so walk a list with forEach()
+template <typename Value>
+class PostingList
+{
+private:
+    std::vector<Value> ids;      // Values in ascending order (once finalized)
+    std::vector<int> freqs;      // Frequency of ids[i] is freqs[i]
+    std::vector<uint8_t> packed; // Compressed entries once finalized; ids and freqs are then empty
+    size_t packedCount;          // Number of compressed entries
+    bool sorted;                 // False if a value was appended out of order since the last finalize
+
+    // Only document ID lists are compressed
+    static const bool COMPRESSED = std::is_same<Value, DocId>::value;
+
+    // Decodes a compressed list back into ids and freqs so it can take new entries. Kept out of line: add() runs
+    // once per match of a query and has to stay small enough to be inlined
+    __attribute__((noinline)) void unpack()
+    {
+        PostingView<Value> packedView = view();
+        ids.reserve(packedCount);
+        freqs.reserve(packedCount);
+        packedView.forEach([this](const Value &v, int freq)
+                           {
+                               ids.push_back(v);
+                               freqs.push_back(freq); });
+        packed = std::vector<uint8_t>();
+        packedCount = 0;
+    }
+
+public:
+    PostingList() : packedCount{0}, sorted{true} {}
+
+    // Adds freq occurrences of v. Values normally arrive in ascending order (documents are indexed one after
+    // the other), so this is an append or an increment of the last entry; anything else is fixed by finalize()
+    void add(const Value &v, int freq = 1)
+    {
+        if (!packed.empty())
+        {
+            unpack();
+        }
+        if (!ids.empty() && !(ids.back() < v))
+        {
+            if (!(v < ids.back())) // same value as the last entry
+            {
+                freqs.back() += freq;
+                return;
+            }
+            sorted = false;
+        }
+        ids.push_back(v);
+        freqs.push_back(freq);
+    }
+
+    // Sorts the entries if needed, combines duplicate values and releases unused capacity. Document ID lists are
+    // then compressed, with the word counts of the first lengthCount documents in lengths (if given) recorded in
+    // the block headers for ranked retrieval
+    void finalize(const int *lengths = nullptr, size_t lengthCount = 0)
+    {
+        if (!packed.empty())
+        {
+            return; // Already finalized and compressed
+        }
+        if (!sorted)
+        {
+            std::vector<size_t> order(ids.size());
+            for (size_t i = 0; i < order.size(); i++)
+            {
+                order[i] = i;
+            }
+            std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b)
+                             { return ids[a] < ids[b]; });
+            std::vector<Value> newIds;
+            std::vector<int> newFreqs;
+            for (size_t i : order)
+            {
+                if (!newIds.empty() && !(newIds.back() < ids[i]))
+                {
+                    newFreqs.back() += freqs[i];
+                }
+                else
+                {
+                    newIds.push_back(ids[i]);
+                    newFreqs.push_back(freqs[i]);
+                }
+            }
+            ids.swap(newIds);
+            freqs.swap(newFreqs);
+            sorted = true;
+        }
+        if constexpr (COMPRESSED)
+        {
+            if (!ids.empty())
+            {
+                BlockCodec::encode(ids.data(), freqs.data(), ids.size(), packed, lengths, lengthCount);
+                packed.shrink_to_fit();
+                packedCount = ids.size();
+                ids = std::vector<Value>();
+                freqs = std::vector<int>();
+                return;
+            }
+        }
+        ids.shrink_to_fit();
+        freqs.shrink_to_fit();
+    }
+
+    // Returns the frequency of v, or 0 if v is not in the list
+    int getFrequency(const Value &v) const
+    {
+        if (!packed.empty())
+        {
+            return view().getFrequency(v);
+        }
+        if (!sorted) // only possible before finalize(); fall back to a scan
+        {
+            int total = 0;
+            for (size_t i = 0; i < ids.size(); i++)
+            {
+                if (!(ids[i] < v) && !(v < ids[i]))
+                {
+                    total += freqs[i];
+                }
+            }
+            return total;
+        }
+        auto itr = std::lower_bound(ids.begin(), ids.end(), v);
+        if (itr == ids.end() || v < *itr)
+        {
+            return 0;
+        }
+        return freqs[itr - ids.begin()];
+    }
+
+    // Number of distinct values in the list
+    size_t size() const { return packed.empty() ? ids.size() : packedCount; }
+
+    bool empty() const { return size() == 0; }
+
+    void clear()
+    {
+        ids.clear();
+        freqs.clear();
+        packed.clear();
+        packedCount = 0;
+        sorted = true;
+    }
+
+    // Replaces the entries with a plain copy of a view's entries
+    void assign(const PostingView<Value> &source)
+    {
+        clear();
+        ids.reserve(source.size());
+        freqs.reserve(source.size());
+        source.forEach([this](const Value &v, int freq)
+                       {
+                           ids.push_back(v);
+                           freqs.push_back(freq); });
+    }
+
+    // Whether finalize() has compressed the list
+    bool compressed() const { return !packed.empty(); }
+
+    // Calls f(value, frequency) for every entry, in order
+    template <typename F>
+    void forEach(F f) const
+    {
+        if (!packed.empty())
+        {
+            view().forEach(f);
+            return;
+        }
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            f(ids[i], freqs[i]);
+        }
+    }
+
+    // Writes the entries as "value,frequency;" in order, decoding a compressed list on the way; the containers'
+    // print functions write each key's list this way
+    void print(std::ostream &out) const
+    {
+        forEach([&out](const Value &v, int freq)
+                { out << v << "," << freq << ";"; });
+    }
+
+    // Value and frequency of the i-th entry
+    const Value &getId(size_t i) const { return ids[i]; }
+    int getFreq(size_t i) const { return freqs[i]; }
+
+    // Contiguous arrays backing the list, for linear scans
+    const std::vector<Value> &getIds() const { return ids; }
+    const std::vector<int> &getFreqs() const { return freqs; }
+
+    // View of the list; only meaningful while the list is sorted (always true after finalize())
+    PostingView<Value> view() const
+    {
+        if (!packed.empty())
+        {
+            return PostingView<Value>(packed.data(), packed.size(), packedCount);
+        }
+        return PostingView<Value>(ids.data(), freqs.data(), ids.size());
+    }
+};
+#endif
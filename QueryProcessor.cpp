@@ -1,13 +1,66 @@
 #include "QueryProcessor.h"
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+// Block score bounds are inflated by this factor so that summing scores in a different order than their bounds can
+// never leave a bound a rounding error below the score it stands for
+static const double BOUND_SLACK = 1 + 1e-9;
+
+namespace
+{
+    // Reads the frequencies of a list by position, positions in ascending order, decoding a block of them at a
+    // time (a plain list is read in place)
+    class FrequencyReader
+    {
+    private:
+        const PostingView<DocId> &list;
+        size_t block;                         // Block whose frequencies data points at, blockCount() before the first
+        const int *data;
+        int buffer[BlockCodec::BLOCK_SIZE];   // Decoded frequencies of a compressed block
+
+    public:
+        explicit FrequencyReader(const PostingView<DocId> &l) : list{l}, block{l.blockCount()}, data{nullptr} {}
+
+        int operator()(size_t position)
+        {
+            if (position / BlockCodec::BLOCK_SIZE != block)
+            {
+                load(position / BlockCodec::BLOCK_SIZE);
+            }
+            return data[position % BlockCodec::BLOCK_SIZE];
+        }
+
+        void load(size_t b)
+        {
+            block = b;
+            data = list.blockFreqs(block, buffer);
+        }
+    };
+}
 
 // Sets the IndexHandler object for the QueryProcessor
-void QueryProcessor::setIndexHandler(IndexHandler i)
+void QueryProcessor::setIndexHandler(std::shared_ptr<const IndexHandler> i)
 {
-    indexObject = i; // Assign the passed IndexHandler object to indexObject
+    indexObject = i; // Share the index instead of copying it
+    stopWords = indexObject->getStopWords(); // Phrases leave out the words the index was built without
+    scorer->setCorpus(indexObject->getWordCounts(), indexObject->getDocSize(), indexObject->getAverageWordCount(),
+                      indexObject->getRelativeWordCounts());
+}
+
+// Sets the ranking function used by Relevancy
+void QueryProcessor::setScorer(std::shared_ptr<Scorer> s)
+{
+    scorer = s;
+    if (indexObject) // Otherwise it is bound once an index is set
+    {
+        scorer->setCorpus(indexObject->getWordCounts(), indexObject->getDocSize(), indexObject->getAverageWordCount(),
+                          indexObject->getRelativeWordCounts());
+    }
 }
 
 // Parses the query answer and processes it
-std::map<std::string, int> QueryProcessor::parsingAnswer(std::string answer) // Parses the answer from the UI
+PostingView<DocId> QueryProcessor::parsingAnswer(std::string answer) // Parses the answer from the UI
 {
     storage.clear(); // Clear any previous data in storage
     std::string temp;
@@ -22,125 +75,674 @@ std::map<std::string, int> QueryProcessor::parsingAnswer(std::string answer) //
 }
 
 // Dissects the query, processes different types of search terms and computes the relevant documents
-std::map<std::string, int> QueryProcessor::disectAnswer()
+PostingView<DocId> QueryProcessor::disectAnswer()
 {
-    // Loop through each term in the storage
+    required.clear();
+    excluded.clear();
+    relDocs.clear();
+    sendTo = PostingView<DocId>();
+    if (!indexObject)
+    {
+        return sendTo; // No index has been built or read yet
+    }
+
+    if (hasOperators())
+    {
+        runExpression();
+        sendTo = relDocs.view();
+        return sendTo;
+    }
+
+    // Planning: resolve every term to its posting list before combining any of them
     for (size_t i = 0; i < storage.size(); i++)
     {
-        // Process organization names
-        if (storage[i].length() > 4 && storage[i].substr(0, 4) == "ORG:")
+        // Process terms to be excluded (negation)
+        if (storage[i].substr(0, 1) == "-")
         {
-            // Extract and process organization term
-            std::string term = storage[i].substr(4, storage[i].length() - 4);
-            std::map<std::string, int> docs = indexObject.getOrgs(term);
-            relDocs = intersection(relevantDocuments, docs);
+            excluded.push_back(lookup(storage[i].substr(1)));
         }
-        // Process people names
-        else if (storage[i].length() > 7 && storage[i].substr(0, 7) == "PERSON:")
+        // Process regular terms, organizations and people (an empty token comes from repeated spaces and is skipped)
+        else if (!storage[i].empty())
         {
-            // Extract and process person term
-            std::string term = storage[i].substr(7, storage[i].length() - 7);
-            std::map<std::string, int> docs = indexObject.getPeople(term);
-            relDocs = intersection(relevantDocuments, docs);
+            required.push_back(lookup(storage[i]));
         }
-        // Process terms to be excluded (negation)
-        else if (storage[i].substr(0, 1) == "-")
+    }
+    if (required.empty())
+    {
+        return sendTo; // Negations alone match nothing
+    }
+    if (matchMode == MATCH_ANY)
+    {
+        rankAny(); // Ranks while it matches, so there is no separate Relevancy pass
+        sendTo = relDocs.view();
+        return sendTo;
+    }
+
+    // Execution: the rarest list is decoded once into an array of candidates, then the candidates are
+    // intersected with every other list, rarest first, by the array kernels of Intersect.h; a compressed list only
+    // has the blocks that can hold a candidate decoded. Each candidate carries its frequency in the rarest list and,
+    // when ranking, its score so far, to which every list adds its term's score as it is intersected (in the same
+    // order Relevancy() sums them), so ranking needs no second pass over the lists. The matches of the last list go
+    // straight into the results. Negations only ever remove documents, so they are only looked up for documents
+    // that are in every required list
+    std::stable_sort(required.begin(), required.end(), [](const PostingView<DocId> &a, const PostingView<DocId> &b)
+                     { return a.size() < b.size(); });
+    const PostingView<DocId> &lead = required[0];
+    const bool ranked = resultCount > 0;
+    termWeights.clear();
+    for (const auto &list : required)
+    {
+        termWeights.push_back(ranked ? scorer->termWeight(list.size()) : 0);
+    }
+    auto score = [&](size_t term, DocId id, int freq)
+    {
+        scorer->setWeight(termWeights[term]);
+        return scorer->score(id, freq);
+    };
+    std::vector<PostingCursor<DocId>> negated;
+    negated.reserve(excluded.size());
+    for (const auto &list : excluded)
+    {
+        negated.emplace_back(list);
+    }
+    auto isNegated = [&negated](DocId candidate)
+    {
+        for (auto &cursor : negated)
+        {
+            cursor.advance(candidate);
+            if (!cursor.atEnd() && cursor.value() == candidate)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+    relScores.clear();
+    auto accept = [&](DocId candidate, int freq, double total)
+    {
+        if (negated.empty() || !isNegated(candidate))
+        {
+            relDocs.add(candidate, freq); // Frequencies are taken from the rarest list
+            if (ranked)
+            {
+                relScores.push_back(total);
+            }
+        }
+    };
+    candidates.resize(lead.size());
+    candidateFreqs.resize(lead.size());
+    for (size_t b = 0; b < lead.blockCount(); b++)
+    {
+        lead.decodeBlock(b, candidates.data() + b * BlockCodec::BLOCK_SIZE, candidateFreqs.data() + b * BlockCodec::BLOCK_SIZE);
+    }
+    if (required.size() == 1)
+    {
+        for (size_t k = 0; k < candidates.size(); k++)
         {
-            // Extract and process negated term
-            std::string term = storage[i].substr(1, storage[i].length() - 1);
-            Porter2Stemmer::trim(term);
-            Porter2Stemmer::stem(term);
-            std::map<std::string, int> docs = indexObject.getWords(term);
-            relDocs = complement(relevantDocuments, docs);
+            accept(candidates[k], candidateFreqs[k], ranked ? score(0, candidates[k], candidateFreqs[k]) : 0);
+        }
+    }
+    // Intersects the candidates with list i; instantiated with and without ranking so that the per-match code the
+    // kernels inline stays small when there is nothing to score
+    auto intersectWith = [&](size_t i, auto ranking)
+    {
+        constexpr bool RANKED = decltype(ranking)::value;
+        const bool last = i + 1 == required.size();
+        FrequencyReader termFreq(required[i]);
+        size_t kept = 0;
+        if (!last) // The matches of the last list are not kept
+        {
+            survivors.resize(candidates.size());
+            survivorFreqs.resize(candidates.size());
+            survivorScores.resize(RANKED ? candidates.size() : 0);
+        }
+        Intersect::intersect(candidates.data(), candidates.size(), required[i], [&](size_t k, size_t j)
+                             {
+                                 const int freq = candidateFreqs[k];
+                                 double total = 0;
+                                 if constexpr (RANKED)
+                                 {
+                                     // The first candidates are the rarest list itself, which has not been scored yet
+                                     total = (i == 1 ? score(0, candidates[k], freq) : candidateScores[k]) + score(i, candidates[k], termFreq(j));
+                                 }
+                                 if (last)
+                                 {
+                                     accept(candidates[k], freq, total);
+                                     return;
+                                 }
+                                 survivors[kept] = candidates[k];
+                                 survivorFreqs[kept] = freq;
+                                 if constexpr (RANKED)
+                                 {
+                                     survivorScores[kept] = total;
+                                 }
+                                 kept++; });
+        survivors.resize(kept);
+        survivorFreqs.resize(kept);
+        survivorScores.resize(RANKED ? kept : 0);
+        candidates.swap(survivors);
+        candidateFreqs.swap(survivorFreqs);
+        candidateScores.swap(survivorScores);
+    };
+    for (size_t i = 1; i < required.size() && !candidates.empty(); i++)
+    {
+        if (ranked)
+        {
+            intersectWith(i, std::true_type());
         }
-        // Process regular terms
         else
         {
-            // Extract and process regular term
-            std::string term = storage[i];
-            Porter2Stemmer::trim(term);
-            Porter2Stemmer::stem(term);
-            if (i == 0)
+            intersectWith(i, std::false_type());
+        }
+    }
+    sendTo = relDocs.view();
+
+    // The heap's top is the worst of the k best documents seen so far
+    if (ranked)
+    {
+        TopK best;
+        for (size_t i = 0; i < sendTo.size(); i++)
+        {
+            offer(best, ScoredDoc{relScores[i], sendTo.getId(i)});
+        }
+        collect(best);
+    }
+    return sendTo;
+}
+
+// Resolves one query term to its posting list
+PostingView<DocId> QueryProcessor::lookup(const std::string &token) const
+{
+    // Process organization names
+    if (token.length() > 4 && token.substr(0, 4) == "ORG:")
+    {
+        return indexObject->getOrgs(token.substr(4));
+    }
+    // Process people names
+    if (token.length() > 7 && token.substr(0, 7) == "PERSON:")
+    {
+        return indexObject->getPeople(token.substr(7));
+    }
+    // Process regular terms
+    std::string term = token;
+    Porter2Stemmer::trim(term);
+    StemCache::shared().stem(term);
+    return indexObject->getWords(term);
+}
+
+// Checks the query for the operators only the match cursors handle
+bool QueryProcessor::hasOperators() const
+{
+    for (const auto &word : storage)
+    {
+        if (word == "OR" || word.find_first_of("()\"") != std::string::npos)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parses a group of ANDed operands, some of them ORed together
+std::unique_ptr<MatchCursor> QueryProcessor::parseGroup(const std::vector<std::string> &tokens, size_t &position, bool nested)
+{
+    std::vector<std::unique_ptr<MatchCursor>> operands, excluded;
+    while (position < tokens.size())
+    {
+        if (tokens[position] == ")")
+        {
+            if (nested)
             {
-                relevantDocuments = indexObject.getWords(term);
-                sendTo = relevantDocuments;
+                break; // The end of the group, which the caller takes
             }
-            else
+            position++; // A stray closing parenthesis
+            continue;
+        }
+        if (tokens[position] == "OR")
+        {
+            position++; // An OR with nothing before it
+            continue;
+        }
+        bool negated;
+        std::unique_ptr<MatchCursor> operand = parseOperand(tokens, position, negated);
+        if (position < tokens.size() && tokens[position] == "OR")
+        {
+            // A negation has nothing to exclude from as an alternative of an OR, so it is dropped
+            std::vector<std::unique_ptr<MatchCursor>> alternatives;
+            if (operand && !negated)
             {
-                std::map<std::string, int> docs = indexObject.getWords(term);
-                relDocs = intersection(relevantDocuments, docs);
+                alternatives.push_back(std::move(operand));
             }
+            while (position < tokens.size() && tokens[position] == "OR")
+            {
+                position++;
+                std::unique_ptr<MatchCursor> alternative = parseOperand(tokens, position, negated);
+                if (alternative && !negated)
+                {
+                    alternatives.push_back(std::move(alternative));
+                }
+            }
+            operands.push_back(std::make_unique<OrMatch>(std::move(alternatives)));
+        }
+        else if (operand)
+        {
+            (negated ? excluded : operands).push_back(std::move(operand));
         }
     }
-    // Calculate relevancy of documents
-    Relevancy(sendTo);
-    return relDocs;
+    if (!nested && matchMode == MATCH_ANY && operands.size() > 1)
+    {
+        std::unique_ptr<MatchCursor> any = std::make_unique<OrMatch>(std::move(operands));
+        operands.clear();
+        operands.push_back(std::move(any));
+    }
+    return std::make_unique<AndMatch>(std::move(operands), std::move(excluded));
 }
 
-// Computes the intersection of two document maps
-std::map<std::string, int> QueryProcessor::intersection(std::map<std::string, int> relevantDocuments, std::map<std::string, int> docs) // documents in "A" and "B"
+// Parses a term or a parenthesized group, either of them possibly negated
+std::unique_ptr<MatchCursor> QueryProcessor::parseOperand(const std::vector<std::string> &tokens, size_t &position, bool &negated)
 {
-    // Logic to find the intersection (common documents) between relevantDocuments and docs
-    std::map<std::string, int> finalVector;
-    for (const auto &itr : relevantDocuments)
+    negated = false;
+    if (position == tokens.size() || tokens[position] == ")" || tokens[position] == "OR")
     {
-        if (docs.find(itr.first) != docs.end())
+        return nullptr;
+    }
+    std::string token = tokens[position++];
+    if (token == "-") // Split off a "-(" or typed on its own
+    {
+        negated = true;
+        if (position == tokens.size() || tokens[position] != "(")
         {
-            finalVector.emplace(itr.first, itr.second);
+            return nullptr;
         }
+        token = tokens[position++];
     }
-    sendTo = finalVector;
+    if (token == "(")
+    {
+        std::unique_ptr<MatchCursor> group = parseGroup(tokens, position, true);
+        if (position < tokens.size())
+        {
+            position++; // The closing parenthesis; a missing one is taken to be at the end
+        }
+        return group;
+    }
+    if (token[0] == '-')
+    {
+        negated = true;
+        token.erase(0, 1);
+    }
+    if (!token.empty() && token[0] == '"')
+    {
+        return parsePhrase(token);
+    }
+    return std::make_unique<TermMatch>(lookup(token), *scorer);
+}
+
+// Resolves the words of a phrase and matches them by position, or as an AND without positions
+std::unique_ptr<MatchCursor> QueryProcessor::parsePhrase(const std::string &token)
+{
+    size_t closing = token.find('"', 1);
+    std::string text = token.substr(1, closing == std::string::npos ? std::string::npos : closing - 1);
+    uint32_t slop = 0;
+    if (closing != std::string::npos && closing + 1 < token.size() && token[closing + 1] == '~')
+    {
+        slop = std::strtoul(token.c_str() + closing + 2, nullptr, 10);
+    }
+
+    // Every token takes a position, as in DocumentParser, so the words keep the gaps of the stopwords between them
+    std::vector<PhraseMatch::Word> words;
+    Tokenizer tokens(text);
+    for (uint32_t offset = 0; tokens.next(); offset++)
+    {
+        std::string &word = tokens.buffer();
+        StemCache::shared().stem(word);
+        if (!stopWords.contains(word))
+        {
+            words.push_back(PhraseMatch::Word{indexObject->getWords(word), indexObject->getPositions(word), offset});
+        }
+    }
+    if (words.empty())
+    {
+        return nullptr;
+    }
+    if (words.size() == 1)
+    {
+        return std::make_unique<TermMatch>(words[0].list, *scorer);
+    }
+    if (!indexObject->hasPositions())
+    {
+        std::vector<std::unique_ptr<MatchCursor>> operands;
+        for (const auto &word : words)
+        {
+            operands.push_back(std::make_unique<TermMatch>(word.list, *scorer));
+        }
+        return std::make_unique<AndMatch>(std::move(operands), std::vector<std::unique_ptr<MatchCursor>>());
+    }
+    return std::make_unique<PhraseMatch>(words, slop, *scorer);
+}
+
+// Matches and scores the query in a single pass over its cursor tree
+void QueryProcessor::runExpression()
+{
+    // Split the parentheses off the words: "(bond" becomes "(" and "bond", "yield))" "yield", ")" and ")", and the
+    // "-" of "-(" is kept apart so that it negates the group. A quoted phrase runs on to the word with its closing
+    // quote and stays one token, spaces included
+    std::vector<std::string> tokens;
+    for (size_t w = 0; w < storage.size(); w++)
+    {
+        std::string word = storage[w];
+        size_t first = 0;
+        while (first < word.size() && (word[first] == '(' || (word[first] == '-' && first + 1 < word.size() && word[first + 1] == '(')))
+        {
+            tokens.push_back(std::string(1, word[first++]));
+        }
+        size_t quote = first < word.size() && word[first] == '-' ? first + 1 : first;
+        if (quote < word.size() && word[quote] == '"')
+        {
+            while (word.find('"', quote + 1) == std::string::npos && w + 1 < storage.size())
+            {
+                word += " " + storage[++w];
+            }
+        }
+        size_t last = word.size(), closing = 0;
+        while (last > first && word[last - 1] == ')')
+        {
+            last--;
+            closing++;
+        }
+        if (last > first)
+        {
+            tokens.push_back(word.substr(first, last - first));
+        }
+        tokens.insert(tokens.end(), closing, ")");
+    }
+
+    size_t position = 0;
+    std::unique_ptr<MatchCursor> root = parseGroup(tokens, position, false);
+    TopK best;
+    for (; !root->atEnd(); root->next())
+    {
+        DocId id = root->value();
+        relDocs.add(id, root->freq());
+        if (resultCount > 0)
+        {
+            offer(best, ScoredDoc{root->score(), id});
+        }
+    }
+    collect(best);
+}
+
+// Returns list itself if it is plain, or a view of a plain copy made in storage if it is compressed
+PostingView<DocId> QueryProcessor::plainView(const PostingView<DocId> &list, PostingList<DocId> &storage)
+{
+    if (!list.compressed())
+    {
+        return list;
+    }
+    storage.assign(list);
+    return storage.view();
+}
+
+// Computes the intersection of two posting lists
+PostingList<DocId> QueryProcessor::intersection(const PostingView<DocId> &relevantDocuments, const PostingView<DocId> &docs) // documents in "A" and "B"
+{
+    // Both lists are sorted by document ID; the first is decoded once and the blocks of the second that can hold
+    // one of its documents are intersected with it by the same kernels as an AND query. Frequencies are taken from
+    // the first list
+    PostingList<DocId> plain;
+    PostingView<DocId> candidates = plainView(relevantDocuments, plain);
+    PostingList<DocId> finalVector;
+    Intersect::intersect(candidates.idData(), candidates.size(), docs, [&finalVector, &candidates](size_t i, size_t)
+                         { finalVector.add(candidates.getId(i), candidates.getFreq(i)); });
     return finalVector;
 }
 
-// Computes the complement of two document maps
-std::map<std::string, int> QueryProcessor::complement(std::map<std::string, int> relevantDocuments, std::map<std::string, int> docs) // documents in "A" and not "B"
+// Computes the complement of two posting lists
+PostingList<DocId> QueryProcessor::complement(const PostingView<DocId> &relevantDocuments, const PostingView<DocId> &docs) // documents in "A" and not "B"
 {
-    // Logic to find the complement (documents in relevantDocuments but not in docs)
-    std::map<std::string, int> finalVector;
-    for (const auto &itr : relevantDocuments)
+    // Advance the cursor of the second list to each document of the first, skipping a long exclusion list over
+    PostingList<DocId> finalVector;
+    PostingCursor<DocId> a(relevantDocuments), b(docs);
+    for (; !a.atEnd(); a.next())
     {
-        if (docs.find(itr.first) == docs.end())
+        b.advance(a.value());
+        if (b.atEnd() || b.value() != a.value())
         {
-            finalVector[itr.first] = itr.second;
+            finalVector.add(a.value(), a.freq());
         }
     }
-    sendTo = finalVector;
     return finalVector;
 }
 
-// Calculate the relevancy of documents based on term frequency-inverse document frequency (tf-idf)
-std::vector<std::string> QueryProcessor::Relevancy(std::map<std::string, int> sendTo)
+// Calculate the relevancy of documents with the configured scorer (BM25 or tf-idf)
+// and keep the best resultCount of them with a bounded min-heap: O(n log k) instead of a full sort
+std::vector<std::string> QueryProcessor::Relevancy(const PostingView<DocId> &documents)
+{
+    if (documents.empty() || resultCount <= 0)
+    {
+        return printVector;
+    }
+    PostingList<DocId> plain;
+    PostingView<DocId> sendTo = plainView(documents, plain); // Candidates are addressed by position
+
+    // Every candidate is in every required list, so intersecting each term with the candidates, one term at a
+    // time, finds its frequencies; idf is then set once per term. Without planned terms (a direct call) the
+    // candidates' own frequencies are scored. A list as long as the candidates holds exactly them, so its
+    // frequencies are read in order without intersecting
+    std::vector<PostingView<DocId>> terms = required;
+    if (terms.empty())
+    {
+        terms.push_back(sendTo);
+    }
+    std::vector<double> scores(sendTo.size(), 0);
+    for (const auto &term : terms)
+    {
+        scorer->setTerm(term.size());
+        if (term.size() == sendTo.size())
+        {
+            size_t i = 0;
+            term.forEach([&](DocId id, int freq)
+                         { scores[i++] += scorer->score(id, freq); });
+            continue;
+        }
+        FrequencyReader freq(term);
+        Intersect::intersect(sendTo.idData(), sendTo.size(), term, [&](size_t i, size_t j)
+                             { scores[i] += scorer->score(sendTo.getId(i), freq(j)); });
+    }
+
+    // The heap's top is the worst of the k best documents seen so far
+    TopK best;
+    for (size_t i = 0; i < sendTo.size(); i++)
+    {
+        offer(best, ScoredDoc{scores[i], sendTo.getId(i)});
+    }
+    collect(best);
+    return printVector;
+}
+
+// Adds doc to the top k, which offer() has found it belongs in
+void QueryProcessor::admit(TopK &best, const ScoredDoc &doc) const
 {
-    for (auto &itr : sendTo)
+    if ((int)best.size() == resultCount)
     {
-        // Calculate tf-idf score for each document
-        double wordCount = indexObject.getWordCount(itr.first);
-        double tf = (double)(itr.second / wordCount);
-        double idf = log2((double)(indexObject.getDocSize() / sendTo.size()));
-        itr.second = tf * idf;
+        best.pop(); // Evict the current worst to make room
     }
-    // Logic to populate printVector with the top 15 relevant documents (or less if fewer are available)
-    if (sendTo.size() <= 15)
+    best.push(doc);
+}
+
+// Moves the top k into the results
+void QueryProcessor::collect(TopK &best)
+{
+    // Popping yields worst first, so fill the results from the back
+    std::vector<ScoredDoc> ranked(best.size());
+    for (size_t i = ranked.size(); i-- > 0;)
+    {
+        ranked[i] = best.top();
+        best.pop();
+    }
+    for (const auto &doc : ranked)
+    {
+        printVector.push_back(indexObject->getDocPath(doc.id));
+        resultVector.push_back(doc.id);
+    }
+}
+
+// Block-Max WAND. Each term knows the highest score it can give any document (maxScore) and, from the block
+// headers, the highest score within each of its blocks. The cursors are kept sorted by their current document; the
+// pivot is the first cursor at which the maxScores of it and every cursor before it add up to more than the worst
+// score in the top k, so no document before the pivot's can enter the top k. The pivot document is only scored if
+// the bounds of the blocks holding it add up to enough as well; otherwise every cursor up to the pivot jumps past
+// the end of the first of those blocks at once. Common terms thus only have their postings decoded around the
+// documents that can still make it
+void QueryProcessor::rankAny()
+{
+    if (resultCount <= 0)
+    {
+        return;
+    }
+
+    // A required term with its cursor and score bounds
+    struct WandTerm
+    {
+        PostingCursor<DocId> cursor;
+        double weight;                   // The scorer's weight of the term
+        std::vector<double> blockBounds; // Highest score in each block
+        double maxScore;                 // Highest score in the whole list
+    };
+    std::vector<WandTerm> terms;
+    terms.reserve(required.size());
+    for (const auto &list : required)
     {
-        for (const auto &itr : sendTo)
+        if (list.empty())
         {
-            printVector.push_back(itr.first);
+            continue; // A term that is not indexed matches nothing and scores nothing
         }
+        WandTerm term{PostingCursor<DocId>(list), scorer->termWeight(list.size()), std::vector<double>(list.blockCount()), 0};
+        scorer->setWeight(term.weight);
+        for (size_t b = 0; b < list.blockCount(); b++)
+        {
+            term.blockBounds[b] = scorer->bound(list.blockMaxFreq(b), list.blockMinLength(b)) * BOUND_SLACK;
+            term.maxScore = std::max(term.maxScore, term.blockBounds[b]);
+        }
+        terms.push_back(std::move(term));
+    }
+    std::vector<PostingCursor<DocId>> negated;
+    negated.reserve(excluded.size());
+    for (const auto &list : excluded)
+    {
+        negated.emplace_back(list);
+    }
+
+    std::vector<WandTerm *> order; // Terms whose cursors are not at the end, by current document
+    for (auto &term : terms)
+    {
+        order.push_back(&term);
     }
-    else
+    TopK best;
+    while (true)
     {
-        int index = 0;
-        for (const auto &itr : sendTo)
+        order.erase(std::remove_if(order.begin(), order.end(), [](const WandTerm *t)
+                                   { return t->cursor.atEnd(); }),
+                    order.end());
+        std::sort(order.begin(), order.end(), [](const WandTerm *a, const WandTerm *b)
+                  { return a->cursor.value() < b->cursor.value(); });
+
+        // Until there are k results every document can make it
+        const double threshold = (int)best.size() < resultCount ? -std::numeric_limits<double>::infinity() : best.top().score;
+        double upper = 0;
+        size_t pivot = 0;
+        while (pivot < order.size() && !((upper += order[pivot]->maxScore) > threshold))
+        {
+            pivot++;
+        }
+        if (pivot == order.size())
         {
-            if (index < 15)
+            break; // Not even all the remaining terms together can beat the top k
+        }
+        const DocId candidate = order[pivot]->cursor.value();
+        while (pivot + 1 < order.size() && order[pivot + 1]->cursor.value() == candidate)
+        {
+            pivot++; // Every term at the candidate takes part
+        }
+
+        // Bounds of the blocks the candidate would be in, and the last document they cover together
+        double blockUpper = 0;
+        DocId blockEnd = std::numeric_limits<DocId>::max();
+        for (size_t i = 0; i <= pivot; i++)
+        {
+            const PostingView<DocId> &list = order[i]->cursor.view();
+            size_t b = list.findBlock(candidate, order[i]->cursor.currentBlock());
+            if (b < list.blockCount())
+            {
+                blockUpper += order[i]->blockBounds[b];
+                blockEnd = std::min(blockEnd, list.blockLast(b));
+            }
+        }
+
+        if (!(blockUpper > threshold))
+        {
+            // No document up to blockEnd can make it either, and the terms after the pivot start later still
+            DocId next = blockEnd + 1;
+            if (pivot + 1 < order.size())
+            {
+                next = std::min(next, order[pivot + 1]->cursor.value());
+            }
+            for (size_t i = 0; i <= pivot; i++)
             {
-                printVector.push_back(itr.first);
-                ++index;
+                order[i]->cursor.advance(next);
+            }
+        }
+        else if (order[0]->cursor.value() != candidate)
+        {
+            // The candidate may make it, but the terms before it have to catch up first
+            for (size_t i = 0; i < pivot; i++)
+            {
+                order[i]->cursor.advance(candidate);
+            }
+        }
+        else
+        {
+            // Every term up to the pivot is at the candidate: score it, in query order so that equal documents
+            // always get exactly equal scores
+            bool keep = true;
+            for (auto &cursor : negated)
+            {
+                cursor.advance(candidate);
+                if (!cursor.atEnd() && cursor.value() == candidate)
+                {
+                    keep = false;
+                    break;
+                }
+            }
+            if (keep)
+            {
+                double score = 0;
+                for (auto &term : terms)
+                {
+                    if (!term.cursor.atEnd() && term.cursor.value() == candidate)
+                    {
+                        scorer->setWeight(term.weight);
+                        score += scorer->score(candidate, term.cursor.freq());
+                    }
+                }
+                offer(best, ScoredDoc{score, candidate});
+            }
+            for (size_t i = 0; i <= pivot; i++)
+            {
+                order[i]->cursor.next();
             }
-            else
-                break;
         }
     }
-    return printVector;
+
+    // The results are also handed back as a posting list, in document ID order
+    std::vector<DocId> ids;
+    for (TopK copy = best; !copy.empty(); copy.pop())
+    {
+        ids.push_back(copy.top().id);
+    }
+    std::sort(ids.begin(), ids.end());
+    for (DocId id : ids)
+    {
+        relDocs.add(id);
+    }
+    collect(best);
 }
@@ -2,25 +2,121 @@
 #define QUERY_PROCESSOR_H
 
 #include <vector>
+#include <queue>
 #include <algorithm>
 #include <iostream>
 #include <string>
 #include <math.h>
 #include <sstream>
+#include <memory>
 #include "IndexHandler.h"
+#include "Scorer.h"
+#include "Intersect.h"
+#include "PostingCursor.h"
+#include "MatchCursor.h"
 #include "porter2_stemmer.h"
+#include "StemCache.h"
+#include "StopWords.h"
+#include "Tokenizer.h"
 
 // Class definition for QueryProcessor
 class QueryProcessor
 {
+public:
+    // How the plain terms of a query combine: every term must match (the default), or any of them may, in which case
+    // only the top resultCount documents are found, by Block-Max WAND over the block score bounds of the lists
+    enum MatchMode
+    {
+        MATCH_ALL,
+        MATCH_ANY
+    };
+
 private:
     // Private member variables
-    std::vector<std::string> storage;             // Stores query components during processing
-    std::map<std::string, int> relevantDocuments; // Maps documents to their relevance scores
-    std::map<std::string, int> relDocs;           // Another map for storing relevant documents
-    std::map<std::string, int> sendTo;            // Used in processing the query to map documents
-    IndexHandler indexObject;                     // IndexHandler instance for accessing the indexed data
-    std::vector<std::string> printVector;         // Stores the results for printing
+    std::vector<std::string> storage;     // Stores query components during processing
+    std::vector<PostingView<DocId>> required; // Posting lists the results must be in, rarest first once planned
+    std::vector<PostingView<DocId>> excluded; // Posting lists of the negated terms
+    PostingList<DocId> relDocs;               // Documents left after applying the query terms
+    PostingView<DocId> sendTo;                // Documents to rank: a view of relDocs
+    std::shared_ptr<const IndexHandler> indexObject; // Shared, read-only index the queries run against
+    std::vector<std::string> printVector; // Stores the file paths of the results for printing, best first
+    std::vector<DocId> resultVector;      // Document IDs of the results, parallel to printVector
+    int resultCount = 15;                 // Number of results (k) kept by the ranking stage
+    MatchMode matchMode = MATCH_ALL;      // Whether documents need every query term or any of them
+    std::shared_ptr<Scorer> scorer = std::make_shared<Bm25Scorer>(); // Ranking function, bound to indexObject
+    StopWords stopWords;                  // Words left out of indexObject, which phrases skip over
+    std::vector<DocId> candidates, survivors;        // Documents of an AND query in every list intersected so far
+    std::vector<int> candidateFreqs, survivorFreqs;  // Their frequencies in the rarest list
+    std::vector<double> candidateScores, survivorScores; // Their scores so far, when ranking
+    std::vector<double> relScores;                   // Scores of the documents in relDocs, when ranking
+    std::vector<double> termWeights;                 // Weight of each required list of an AND query, when ranking
+
+    // A candidate document and its relevance score
+    struct ScoredDoc
+    {
+        double score;
+        DocId id;
+    };
+
+    // Orders candidates from best to worst: higher score first, lower document ID first on ties
+    struct BetterScore
+    {
+        bool operator()(const ScoredDoc &a, const ScoredDoc &b) const
+        {
+            return a.score > b.score || (a.score == b.score && a.id < b.id);
+        }
+    };
+
+    // The best resultCount documents seen so far; the top is the worst of them
+    typedef std::priority_queue<ScoredDoc, std::vector<ScoredDoc>, BetterScore> TopK;
+
+    // Offers a scored document to the top k. Most documents of a large result cannot beat the worst of the top k,
+    // so that test is inline and only the heap update is a call
+    void offer(TopK &best, const ScoredDoc &doc) const
+    {
+        if ((int)best.size() < resultCount || BetterScore()(doc, best.top()))
+        {
+            admit(best, doc);
+        }
+    }
+
+    // Adds doc to the top k, evicting the worst of them if it is full
+    void admit(TopK &best, const ScoredDoc &doc) const;
+
+    // Empties the top k into printVector and resultVector, best first
+    void collect(TopK &best);
+
+    // Posting list of a query term: a word (trimmed and stemmed), an "ORG:" or a "PERSON:"
+    PostingView<DocId> lookup(const std::string &) const;
+
+    // Whether the query uses OR, parentheses or quoted phrases, which the planned AND query cannot express
+    bool hasOperators() const;
+
+    // Parses the operands of one group of tokens from position on (the whole query unless nested, up to its closing
+    // parenthesis if nested) into a cursor. Operands are ANDed, except by OR, which binds tighter, and at the top
+    // level of a MATCH_ANY query
+    std::unique_ptr<MatchCursor> parseGroup(const std::vector<std::string> &, size_t &position, bool nested);
+
+    // Parses one operand: a term, a "phrase", "(group)" or any of them negated with a "-", which sets negated.
+    // Returns nullptr, taking nothing, at ")", "OR" or the end of the tokens
+    std::unique_ptr<MatchCursor> parseOperand(const std::vector<std::string> &, size_t &position, bool &negated);
+
+    // Parses a quoted phrase, optionally followed by ~N to allow up to N extra words between its words. Its words
+    // are normalized like document text, stopwords keep their place, and the phrase is checked against the word
+    // positions; in an index without positions it matches the documents with all of its words instead. Returns
+    // nullptr for a phrase of stopwords alone
+    std::unique_ptr<MatchCursor> parsePhrase(const std::string &);
+
+    // Runs a query with OR, parentheses or phrases: every matching document goes into relDocs and the best resultCount of
+    // them, as scored while matching, into printVector and resultVector
+    void runExpression();
+
+    // MATCH_ANY: finds the top resultCount documents containing any required term and none of the excluded ones
+    // with Block-Max WAND, fills printVector and resultVector with them and relDocs with their IDs
+    void rankAny();
+
+    // Returns list itself if it is plain, or a view of a plain copy made in storage if it is compressed
+    static PostingView<DocId> plainView(const PostingView<DocId> &list, PostingList<DocId> &storage);
 
 public:
     // Getter for the printVector
@@ -32,31 +128,46 @@ public:
     // Retrieves a specific item from printVector
     std::string getPrint(int num) { return printVector[num]; };
 
+    // Document IDs of the results, in the same order as printVector
+    const std::vector<DocId> &getResultIds() const { return resultVector; };
+
     // Clears the printVector
-    void clearPrintVector() { printVector.clear(); };
+    void clearPrintVector()
+    {
+        printVector.clear();
+        resultVector.clear();
+    };
+
+    // Parses a query string and returns every document matching it (valid until the next query). In MATCH_ANY
+    // mode only the ranked results are returned, in document ID order and with a frequency of 1
+    PostingView<DocId> parsingAnswer(std::string);
 
-    // Parses a query string and returns relevant documents
-    std::map<std::string, int> parsingAnswer(std::string);
+    // Plans and runs the query: resolves all terms, intersects them rarest first and applies negations last, or
+    // ranks the documents with any of the terms in MATCH_ANY mode. Queries with "OR" (binding tighter than the
+    // implicit AND, as in "market bond OR yield"), parentheses or quoted phrases ("bank of america", or
+    // "interest rates"~2 to allow two words in between) are run as a tree of match cursors instead
+    PostingView<DocId> disectAnswer();
 
-    // Dissects the answer to aid in query processing
-    std::map<std::string, int> disectAnswer();
+    // Calculates the intersection of two posting lists - useful in query logic
+    PostingList<DocId> intersection(const PostingView<DocId> &, const PostingView<DocId> &);
 
-    // Calculates the intersection of two maps - useful in query logic
-    std::map<std::string, int> intersection(std::map<std::string, int>, std::map<std::string, int>);
+    // Calculates the complement of two posting lists - useful in query logic
+    PostingList<DocId> complement(const PostingView<DocId> &, const PostingView<DocId> &);
 
-    // Calculates the complement of two maps - useful in query logic
-    std::map<std::string, int> complement(std::map<std::string, int>, std::map<std::string, int>);
+    // Sets the index for query processing; the index is shared, not copied
+    void setIndexHandler(std::shared_ptr<const IndexHandler> i);
 
-    // Sets the IndexHandler object for query processing
-    void setIndexHandler(IndexHandler i);
+    // Replaces the ranking function (BM25 by default) and binds it to the current index
+    void setScorer(std::shared_ptr<Scorer>);
 
-    // Determines the relevancy of documents for the query
-    std::vector<std::string> Relevancy(std::map<std::string, int>);
+    // Sets how many of the most relevant documents the ranking stage keeps
+    void setResultCount(int k) { resultCount = k; };
 
-    // Implements quickSort algorithm for sorting documents based on relevancy
-    void quickSort(std::map<std::string, int> &, int, int);
+    // Sets whether queries match documents with every term (the default) or with any of them
+    void setMatchMode(MatchMode mode) { matchMode = mode; };
 
-    // Helper function for quickSort to partition the map
-    int partition(std::map<std::string, int>, int, int);
+    // Scores the documents for the query with the scorer, summed over the required terms, and keeps the top
+    // resultCount of them, best first
+    std::vector<std::string> Relevancy(const PostingView<DocId> &);
 };
 #endif
@@ -0,0 +1,134 @@
+#include "QueryServer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Runs one query and formats the ranked results as a response
+std::string QueryServer::answer(QueryProcessor &qp, const std::string &query) const
+{
+    qp.clearPrintVector(); // Results of the previous query on this connection
+    qp.parsingAnswer(query);
+    std::string response = std::to_string(qp.getPrintVectorSize()) + "\n";
+    for (DocId id : qp.getResultIds())
+    {
+        std::string title = index->getTitle(id);
+        std::replace(title.begin(), title.end(), '\t', ' '); // Keep one result per line and two fields per result
+        std::replace(title.begin(), title.end(), '\n', ' ');
+        response += index->getDocPath(id) + "\t" + title + "\n";
+    }
+    return response;
+}
+
+// Line protocol over streams, used for stdin/stdout
+void QueryServer::serveStream(std::istream &in, std::ostream &out) const
+{
+    QueryProcessor qp;
+    qp.setIndexHandler(index);
+    std::string line;
+    while (std::getline(in, line))
+    {
+        out << answer(qp, line) << std::flush;
+    }
+}
+
+// Reads lines from a client socket and writes one response per line
+void QueryServer::serveClient(int fd) const
+{
+    QueryProcessor qp;
+    qp.setIndexHandler(index);
+    std::string pending; // Bytes received after the last complete line
+    char buffer[4096];
+    ssize_t received;
+    while ((received = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        pending.append(buffer, received);
+        size_t end;
+        while ((end = pending.find('\n')) != std::string::npos)
+        {
+            std::string query = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            if (!query.empty() && query.back() == '\r')
+            {
+                query.pop_back();
+            }
+            std::string response = answer(qp, query);
+            for (size_t sent = 0; sent < response.size();)
+            {
+                ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0)
+                {
+                    close(fd); // The client went away mid-response
+                    return;
+                }
+                sent += n;
+            }
+        }
+    }
+    close(fd);
+}
+
+// Accepts clients on a Unix-domain socket, one thread each
+bool QueryServer::serveSocket(const std::string &path) const
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Socket path is too long: " << path << std::endl;
+        return false;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    // Remove a socket left behind by a previous server, but never a file that is not a socket
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0)
+    {
+        if (!S_ISSOCK(existing.st_mode))
+        {
+            std::cerr << "Could not listen on " << path << ": it exists and is not a socket" << std::endl;
+            return false;
+        }
+        unlink(path.c_str());
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        std::cerr << "Could not create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0)
+    {
+        std::cerr << "Could not listen on " << path << ": " << std::strerror(errno) << std::endl;
+        close(listener);
+        return false;
+    }
+
+    std::cout << "Listening on " << path << std::endl;
+    while (true)
+    {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            std::cerr << "Could not accept a client: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        // The thread serves from its own copy of the server, which shares the index, so it does not depend on
+        // this object outliving the connection
+        std::thread([server = *this, client]()
+                    { server.serveClient(client); })
+            .detach();
+    }
+    close(listener);
+    return false;
+}
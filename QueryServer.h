@@ -0,0 +1,39 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+// Including necessary header files
+#include "IndexHandler.h"   // Include the IndexHandler header for the resident index
+#include "QueryProcessor.h" // Include the QueryProcessor header for answering queries
+#include <iostream>         // Standard library for input/output streaming
+#include <memory>           // Standard library for shared pointers
+#include <string>           // Standard library for string handling
+
+// Class definition for QueryServer: keeps one index loaded and answers queries until it is stopped.
+//
+// Protocol (one request per line, over a Unix-domain socket or stdin/stdout):
+//   request:  a query in the usual syntax, e.g. "market PERSON:powell -bond"
+//   response: "<count>\n" followed by count lines "<path>\t<title>\n", best first
+// Each socket client is served on its own thread with its own QueryProcessor and its own reference to the index,
+// which is only read.
+class QueryServer
+{
+private:
+    std::shared_ptr<const IndexHandler> index; // The resident index shared by every client
+
+    // Serves one connected socket until the client closes it
+    void serveClient(int fd) const;
+
+public:
+    QueryServer(std::shared_ptr<const IndexHandler> ih) : index{ih} {}
+
+    // Answers one query line with a complete response in the format above
+    std::string answer(QueryProcessor &, const std::string &) const;
+
+    // Answers queries read line by line from in until end of input
+    void serveStream(std::istream &in, std::ostream &out) const;
+
+    // Listens on a Unix-domain socket at path and serves clients until accepting fails; returns false then, or
+    // straight away if it cannot listen
+    bool serveSocket(const std::string &path) const;
+};
+#endif
@@ -0,0 +1,131 @@
+#ifndef SCORER_H
+#define SCORER_H
+#include "PostingList.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Length of each document relative to the average (lengths[id] / averageLength, 1 if the average is 0). Computed once
+// per index snapshot by IndexHandler and shared by every scorer bound to it
+inline std::shared_ptr<const std::vector<float>> relativeLengths(const int *lengths, size_t docCount, double averageLength)
+{
+    std::shared_ptr<std::vector<float>> relative = std::make_shared<std::vector<float>>(docCount);
+    for (size_t i = 0; i < docCount; i++)
+    {
+        (*relative)[i] = averageLength > 0 ? lengths[i] / averageLength : 1;
+    }
+    return relative;
+}
+
+// Interface of a ranking function. A scorer is bound to a corpus once (document lengths indexed by document ID,
+// their average and the shared relative lengths), told the document frequency of each query term, and then scores candidates with a
+// handful of arithmetic operations on contiguous arrays. Every scorer grows with the frequency and shrinks with the
+// document length, which is what lets bound() cap the scores of a whole block of postings
+class Scorer
+{
+protected:
+    double idf = 0; // Weight of the current term
+
+public:
+    virtual ~Scorer() {}
+
+    // Binds the scorer to the length table of an index with docCount documents and to its relative lengths, which
+    // the scorer only references (nullptr to have a scorer that needs them compute its own)
+    virtual void setCorpus(const int *lengths, size_t docCount, double averageLength,
+                           std::shared_ptr<const std::vector<float>> relative) = 0;
+
+    // Per-term part of the score (its idf) for a term that occurs in docFrequency documents
+    virtual double termWeight(size_t docFrequency) const = 0;
+
+    // Makes a term that occurs in docFrequency documents the current term
+    void setTerm(size_t docFrequency) { idf = termWeight(docFrequency); }
+
+    // Makes a term of the given weight the current term; switching between the terms of a query this way costs no
+    // logarithm
+    void setWeight(double weight) { idf = weight; }
+
+    // Scores a document in which the current term occurs freq times
+    virtual double score(DocId id, int freq) const = 0;
+
+    // Upper bound of the current term's score in any document where it occurs at most freq times and that has at
+    // least length words (0 if the length is unknown)
+    virtual double bound(int freq, int length) const = 0;
+};
+
+// Length-normalised term frequency times log2(N / df)
+class TfIdfScorer : public Scorer
+{
+private:
+    const int *lengths = nullptr; // Word count of each document
+    size_t docCount = 0;          // Number of documents in the corpus
+
+public:
+    void setCorpus(const int *l, size_t n, double, std::shared_ptr<const std::vector<float>>) override
+    {
+        lengths = l;
+        docCount = n;
+    }
+
+    double termWeight(size_t docFrequency) const override
+    {
+        return docFrequency > 0 ? std::log2((double)docCount / docFrequency) : 0;
+    }
+
+    double score(DocId id, int freq) const override
+    {
+        return lengths[id] > 0 ? idf * freq / lengths[id] : 0;
+    }
+
+    double bound(int freq, int length) const override
+    {
+        return idf * freq / std::max(length, 1);
+    }
+};
+
+// Okapi BM25. The length normalisation k1 * (1 - b + b * length / averageLength) is read off the index's shared
+// relative lengths, so binding the scorer to a corpus costs nothing per document
+class Bm25Scorer : public Scorer
+{
+private:
+    double k1;                                          // Term frequency saturation
+    double b;                                           // Strength of the length normalisation
+    std::shared_ptr<const std::vector<float>> relative; // Relative length of each document, indexed by document ID
+    const float *lengthRatio = nullptr;                 // relative's data
+    double average = 0;                                 // Average document length
+    size_t docCount = 0;                                // Number of documents in the corpus
+
+    // Length normalisation of a document of the given relative length
+    double norm(double ratio) const { return k1 * (1 - b + b * ratio); }
+
+public:
+    Bm25Scorer(double k1 = 1.2, double b = 0.75) : k1{k1}, b{b} {}
+
+    void setCorpus(const int *lengths, size_t n, double averageLength, std::shared_ptr<const std::vector<float>> r) override
+    {
+        docCount = n;
+        average = averageLength;
+        relative = r ? r : relativeLengths(lengths, n, averageLength);
+        lengthRatio = relative->data();
+    }
+
+    double termWeight(size_t docFrequency) const override
+    {
+        // The "+ 1" keeps idf positive for terms found in more than half of the documents
+        return std::log(1 + ((double)docCount - docFrequency + 0.5) / (docFrequency + 0.5));
+    }
+
+    double score(DocId id, int freq) const override
+    {
+        return idf * freq * (k1 + 1) / (freq + norm(lengthRatio[id]));
+    }
+
+    double bound(int freq, int length) const override
+    {
+        // Rounded to a float exactly like the relative lengths, so the bound is the score of a document of that length
+        float ratio = average > 0 ? length / average : 1;
+        return idf * freq * (k1 + 1) / (freq + norm(ratio));
+    }
+};
+#endif
@@ -2,29 +2,66 @@
 #include <iostream>
 #include <cstdio>
 #include <chrono>
+#include <charconv>
 
 // Function to process input commands for the search engine
 void SearchEngine::input(int num, char **answer)
 {
-  // Check if the command is to create an index
+  // Check if the command is to create an index (supersearch index [--positions] <directory> [threads] [stopword file])
   if (strcmp(answer[1], "index") == 0)
   {
+    // --positions records word positions so the index answers phrase queries, at the cost of a larger index
+    std::vector<char *> args(answer, answer + num);
+    auto flag = std::find_if(args.begin() + 2, args.end(), [](const char *arg)
+                             { return strcmp(arg, "--positions") == 0; });
+    if (flag != args.end())
+    {
+      args.erase(flag);
+      dp.enablePositions();
+    }
+    const char *usage = "Usage: supersearch index [--positions] <directory> [threads] [stopword file]";
+    if (args.size() < 3)
+    {
+      std::cerr << usage << std::endl;
+      exit(-1);
+    }
+    // Use the optional thread count argument, which must be a whole number of at least 1, defaulting to one worker
+    // per hardware thread (hardware_concurrency() is 0 when it cannot tell)
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    if (args.size() > 3)
+    {
+      const char *end = args[3] + strlen(args[3]);
+      std::from_chars_result parsed = std::from_chars(args[3], end, threads);
+      if (parsed.ec != std::errc() || parsed.ptr != end || threads < 1)
+      {
+        std::cerr << "Invalid thread count: " << args[3] << std::endl;
+        std::cerr << usage << std::endl;
+        exit(-1);
+      }
+    }
+    // Use the optional stopword list instead of the built-in one
+    if (args.size() > 4 && !dp.loadStopWords(args[4]))
+    {
+      exit(-1);
+    }
     std::cout << "Reading files..." << std::endl;
-    dp.traverseSubdirectory(answer[2]); // Traverse and parse documents in the specified directory
-    ih = dp.getIndex();                 // Retrieve and set the index from DocumentParser
+    dp.traverseSubdirectory(args[2], threads);   // Traverse and parse documents in the specified directory
+    ih = dp.releaseIndex();                      // Take the built index over from DocumentParser
     std::cout << "Done!" << std::endl;
+    const StemCache &stems = StemCache::shared();
+    std::cout << "Stem cache: " << stems.getHits() << " hits, " << stems.getMisses() << " misses ("
+              << 100 * stems.getHitRate() << "% hit rate)" << std::endl;
     std::cout << "Creating persistence, this may take a minute..." << std::endl;
-    ih.createPersistence(); // Create persistent data for the index
+    ih->createPersistence(); // Create persistent data for the index
     std::cout << "Persistence has been created!" << std::endl;
   }
   // Check if the command is to process a query
   else if (strcmp(answer[1], "query") == 0)
   {
     std::cout << "Reading persistence..." << std::endl;
-    ih.readPersistence(); // Read the persistent data into the index
+    ih = IndexHandler::openPersistence(); // Read the persistent data into the index
     std::cout << "Persistence has been read!" << std::endl;
-    dp.setIndex(ih);        // Set the index for DocumentParser
-    qp.setIndexHandler(ih); // Set the index for QueryProcessor
+    qp.setIndexHandler(ih); // Share the index with QueryProcessor
 
     // Combine the query parts into a single string
     std::string answer2 = answer[2];
@@ -34,14 +71,14 @@ void SearchEngine::input(int num, char **answer)
     }
 
     // Process the query and retrieve relevant documents
-    std::map<std::string, int> relevantDocs = qp.parsingAnswer(answer2);
+    qp.parsingAnswer(answer2);
     int count = 1;
     std::cout << "Here are the most relevant documents" << std::endl;
-    // Print the information of relevant documents
-    for (const auto &item : qp.getPrintVector())
+    // Print the information of relevant documents from the index, without opening them
+    for (DocId id : qp.getResultIds())
     {
       std::cout << count << ". ";
-      dp.printInfo(item); // Print document information
+      dp.printInfo(*ih, id); // Print document information
       std::cout << std::endl;
       ++count;
     }
@@ -64,10 +101,30 @@ void SearchEngine::input(int num, char **answer)
     }
     qp.clearPrintVector(); // Clear the vector for next query
   }
+  // Check if the command is to serve queries (supersearch serve [socket path]) with the index kept loaded
+  else if (strcmp(answer[1], "serve") == 0)
+  {
+    std::cerr << "Reading persistence..." << std::endl; // stdout carries the responses
+    ih = IndexHandler::openPersistence(); // Loaded once for every query that follows
+    std::cerr << "Persistence has been read!" << std::endl;
+    QueryServer server(ih);
+    if (num > 2)
+    {
+      if (!server.serveSocket(answer[2])) // Unix-domain socket, one thread per client
+      {
+        exit(-1);
+      }
+    }
+    else
+    {
+      server.serveStream(std::cin, std::cout); // Line protocol on stdin/stdout
+    }
+  }
   // Check if the command is to interact through the user interface
   else if (strcmp(answer[1], "ui") == 0)
   {
-    ih.readPersistence(); // Read the persistent data into the index
-    ui.initialQuestion(); // Start the user interface interaction
+    ih = IndexHandler::openPersistence(); // Read the persistent data into the index
+    ui.setIndex(ih);                      // The user interface starts out with it
+    ui.initialQuestion();                 // Start the user interface interaction
   }
 }
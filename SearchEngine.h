@@ -6,13 +6,14 @@
 #include "DocumentParser.h" // Include the DocumentParser header for parsing and processing documents
 #include "UserInterface.h"  // Include the UserInterface header for handling user interactions
 #include "QueryProcessor.h" // Include the QueryProcessor header for processing search queries
+#include "QueryServer.h"    // Include the QueryServer header for the resident query server
 
 // Class definition for SearchEngine
 class SearchEngine
 {
 private:
     // Private member variables
-    IndexHandler ih;   // An instance of IndexHandler for handling indexing operations
+    std::shared_ptr<const IndexHandler> ih; // The index, shared with the other components instead of copied
     DocumentParser dp; // An instance of DocumentParser for parsing documents
     UserInterface ui;  // An instance of UserInterface for managing user interactions
     QueryProcessor qp; // An instance of QueryProcessor for processing user queries
@@ -0,0 +1,85 @@
+#include "StemCache.h"
+#include "porter2_stemmer.h"
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+StemCache::StemCache(size_t capacity)
+{
+    size_t perShard = 1;
+    while (perShard * SHARDS < capacity)
+    {
+        perShard *= 2;
+    }
+    slotMask = perShard - 1;
+    for (Shard &shard : shards)
+    {
+        shard.entries.resize(perShard);
+    }
+}
+
+// Looks the word up in its shard and runs the stemmer only on a miss; the stemmer runs without the lock held
+void StemCache::stem(std::string &word)
+{
+    if (word.size() <= 2 || word.size() > MAX_WORD)
+    {
+        word.resize(Porter2Stemmer::stem(&word[0], word.size())); // In place: the stem is never longer
+        return;
+    }
+    size_t h = std::hash<std::string_view>{}(word);
+    Shard &shard = shards[h % SHARDS];
+    size_t slot = (h / SHARDS) & slotMask;
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        const Entry &entry = shard.entries[slot];
+        if (entry.keyLength == word.size() && std::memcmp(entry.key, word.data(), word.size()) == 0)
+        {
+            word.assign(entry.stem, entry.stemLength); // Never longer than the word, so no allocation
+            shard.hits.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
+    Entry computed; // Stemmed in the entry's own buffer, which fits any word that gets this far
+    computed.keyLength = word.size();
+    std::memcpy(computed.key, word.data(), word.size());
+    std::memcpy(computed.stem, word.data(), word.size());
+    computed.stemLength = Porter2Stemmer::stem(computed.stem, word.size());
+    word.assign(computed.stem, computed.stemLength);
+
+    std::lock_guard<std::mutex> guard(shard.lock);
+    shard.entries[slot] = computed;
+}
+
+uint64_t StemCache::getHits() const
+{
+    uint64_t hits = 0;
+    for (const Shard &shard : shards)
+    {
+        hits += shard.hits.load(std::memory_order_relaxed);
+    }
+    return hits;
+}
+
+uint64_t StemCache::getMisses() const
+{
+    uint64_t misses = 0;
+    for (const Shard &shard : shards)
+    {
+        misses += shard.misses.load(std::memory_order_relaxed);
+    }
+    return misses;
+}
+
+double StemCache::getHitRate() const
+{
+    uint64_t hits = getHits(), lookups = hits + getMisses();
+    return lookups == 0 ? 0 : static_cast<double>(hits) / lookups;
+}
+
+StemCache &StemCache::shared()
+{
+    static StemCache cache;
+    return cache;
+}
@@ -0,0 +1,61 @@
+#ifndef STEM_CACHE_H
+#define STEM_CACHE_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Bounded, thread-safe memo of Porter2 stems (surface form -> stem).
+//
+// Text repeats the same few thousand surface forms over and over, so most tokens can skip the stemmer. The
+// cache is split into shards, each guarded by its own mutex so parser threads rarely wait on each other. A
+// shard is a direct-mapped table of fixed-size entries: a word has exactly one slot, and a miss overwrites
+// whatever was there, so memory stays fixed and a lookup never allocates. Words the stemmer leaves alone
+// (2 characters or fewer) and words longer than the stemmer's 35-character cap bypass the cache.
+class StemCache
+{
+private:
+    static const size_t MAX_WORD = 35;  // The stemmer truncates longer words
+    static const size_t SHARDS = 16;    // Independently locked parts of the cache
+
+    struct Entry
+    {
+        uint8_t keyLength = 0; // 0 marks an unused entry
+        uint8_t stemLength = 0;
+        char key[MAX_WORD];
+        char stem[MAX_WORD];
+    };
+
+    struct alignas(64) Shard // Own cache line, so threads locking neighbouring shards do not contend
+    {
+        std::mutex lock;
+        std::vector<Entry> entries;
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+    };
+
+    Shard shards[SHARDS];
+    size_t slotMask; // Entries per shard - 1
+
+public:
+    // A cache holding up to capacity stems (rounded up to a power of two per shard)
+    explicit StemCache(size_t capacity = 1 << 15);
+
+    // Replaces word with its stem, the same as Porter2Stemmer::stem
+    void stem(std::string &word);
+
+    // Number of lookups answered from the cache
+    uint64_t getHits() const;
+
+    // Number of lookups that had to run the stemmer
+    uint64_t getMisses() const;
+
+    // Fraction of lookups answered from the cache, 0 before the first lookup
+    double getHitRate() const;
+
+    // The cache shared by document parsing and query processing
+    static StemCache &shared();
+};
+#endif
@@ -0,0 +1,271 @@
+#include "StopWords.h"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// list of stopwords found from https://gist.github.com/sebleier/554280 NLTK list of english stopwords
+static constexpr std::string_view DEFAULT_WORDS[] = {
+    "able", "about", "above", "abroad", "according", "accordingly", "across", "actually", "adj", "after",
+    "afterwards", "again", "against", "ago", "ahead", "ain't", "all", "allow", "allows", "almost",
+    "alone", "along", "alongside", "already", "also", "although", "always", "am", "amid", "amidst",
+    "among", "amongst", "an", "and", "another", "any", "anybody", "anyhow", "anyone", "anything",
+    "anyway", "anyways", "anywhere", "apart", "appear", "appreciate", "appropriate", "are", "aren't", "around",
+    "as", "a's", "aside", "ask", "asking", "associated", "at", "available", "away", "awfully",
+    "back", "backward", "backwards", "be", "became", "because", "become", "becomes", "becoming", "been",
+    "before", "beforehand", "begin", "behind", "being", "believe", "below", "beside", "besides", "best",
+    "better", "between", "beyond", "both", "brief", "but", "by", "came", "can", "cannot",
+    "cant", "can't", "caption", "cause", "causes", "certain", "certainly", "changes", "clearly", "c'mon",
+    "co", "co.", "com", "come", "comes", "concerning", "consequently", "consider", "considering", "contain",
+    "containing", "contains", "corresponding", "could", "couldn't", "course", "c's", "currently", "dare", "daren't",
+    "definitely", "described", "despite", "did", "didn't", "different", "directly", "do", "does", "doesn't",
+    "doing", "done", "don't", "down", "downwards", "during", "each", "edu", "eg", "eight",
+    "eighty", "either", "else", "elsewhere", "end", "ending", "enough", "entirely", "especially", "et",
+    "etc", "even", "ever", "evermore", "every", "everybody", "everyone", "everything", "everywhere", "ex",
+    "exactly", "example", "except", "fairly", "far", "farther", "few", "fewer", "fifth", "first",
+    "five", "followed", "following", "follows", "for", "forever", "former", "formerly", "forth", "forward",
+    "found", "four", "from", "further", "furthermore", "get", "gets", "getting", "given", "gives",
+    "go", "goes", "going", "gone", "got", "gotten", "greetings", "had", "hadn't", "half",
+    "happens", "hardly", "has", "hasn't", "have", "haven't", "having", "he", "he'd", "he'll",
+    "hello", "help", "hence", "her", "here", "hereafter", "hereby", "herein", "here's", "hereupon",
+    "hers", "herself", "he's", "hi", "him", "himself", "his", "hither", "hopefully", "how",
+    "howbeit", "however", "hundred", "i'd", "ie", "if", "ignored", "i'll", "i'm", "immediate",
+    "in", "inasmuch", "inc", "inc.", "indeed", "indicate", "indicated", "indicates", "inner", "inside",
+    "insofar", "instead", "into", "inward", "is", "isn't", "it", "it'd", "it'll", "its",
+    "it's", "itself", "i've", "just", "k", "keep", "keeps", "kept", "know", "known",
+    "knows", "last", "lately", "later", "latter", "latterly", "least", "less", "lest", "let",
+    "let's", "like", "liked", "likely", "likewise", "little", "look", "looking", "looks", "low",
+    "lower", "ltd", "made", "mainly", "make", "makes", "many", "may", "maybe", "mayn't",
+    "me", "mean", "meantime", "meanwhile", "merely", "might", "mightn't", "mine", "minus", "miss",
+    "more", "moreover", "most", "mostly", "mr", "mrs", "much", "must", "mustn't", "my",
+    "myself", "name", "namely", "nd", "near", "nearly", "necessary", "need", "needn't", "needs",
+    "neither", "never", "neverf", "neverless", "nevertheless", "new", "next", "nine", "ninety", "no",
+    "nobody", "non", "none", "nonetheless", "noone", "no-one", "nor", "normally", "not", "nothing",
+    "notwithstanding", "novel", "now", "nowhere", "obviously", "of", "off", "often", "oh", "ok",
+    "okay", "old", "on", "once", "one", "ones", "one's", "only", "onto", "opposite",
+    "or", "other", "others", "otherwise", "ought", "oughtn't", "our", "ours", "ourselves", "out",
+    "outside", "over", "overall", "own", "particular", "particularly", "past", "per", "perhaps", "placed",
+    "please", "plus", "possible", "presumably", "probably", "provided", "provides", "que", "quite", "qv",
+    "rather", "rd", "re", "really", "reasonably", "recent", "recently", "regarding", "regardless", "regards",
+    "relatively", "respectively", "right", "round", "said", "same", "saw", "say", "saying", "says",
+    "second", "secondly", "see", "seeing", "seem", "seemed", "seeming", "seems", "seen", "self",
+    "selves", "sensible", "sent", "serious", "seriously", "seven", "several", "shall", "shan't", "she",
+    "she'd", "she'll", "she's", "should", "shouldn't", "since", "six", "so", "some", "somebody",
+    "someday", "somehow", "someone", "something", "sometime", "sometimes", "somewhat", "somewhere", "soon", "sorry",
+    "specified", "specify", "specifying", "still", "sub", "such", "sup", "sure", "take", "taken",
+    "taking", "tell", "tends", "th", "than", "thank", "thanks", "thanx", "that", "that'll",
+    "thats", "that's", "that've", "the", "their", "theirs", "them", "themselves", "then", "thence",
+    "there", "thereafter", "thereby", "there'd", "therefore", "therein", "there'll", "there're", "theres", "there's",
+    "thereupon", "there've", "these", "they", "they'd", "they'll", "they're", "they've", "thing", "things",
+    "think", "third", "thirty", "this", "thorough", "thoroughly", "those", "though", "three", "through",
+    "throughout", "thru", "thus", "till", "to", "together", "too", "took", "toward", "towards",
+    "tried", "tries", "truly", "try", "trying", "t's", "twice", "two", "un", "under",
+    "underneath", "undoing", "unfortunately", "unless", "unlike", "unlikely", "until", "unto", "up", "upon",
+    "upwards", "us", "use", "used", "useful", "uses", "using", "usually", "v", "value",
+    "various", "versus", "very", "via", "viz", "vs", "want", "wants", "was", "wasn't",
+    "way", "we", "we'd", "welcome", "well", "we'll", "went", "were", "we're", "weren't",
+    "we've", "what", "whatever", "what'll", "what's", "what've", "when", "whence", "whenever", "where",
+    "whereafter", "whereas", "whereby", "wherein", "where's", "whereupon", "wherever", "whether", "which", "whichever",
+    "while", "whilst", "whither", "who", "who'd", "whoever", "whole", "who'll", "whom", "whomever",
+    "who's", "whose", "why", "will", "willing", "wish", "with", "within", "without", "wonder",
+    "won't", "would", "wouldn't", "yes", "yet", "you", "you'd", "you'll", "your", "you're",
+    "yours", "yourself", "yourselves", "you've", "zero"};
+
+static constexpr size_t DEFAULT_COUNT = sizeof(DEFAULT_WORDS) / sizeof(DEFAULT_WORDS[0]);
+static constexpr size_t DEFAULT_SLOTS = 2048; // Power of two, over three times the number of words
+
+// Hashes the built-in list; a duplicate word is only placed once, which the check below rejects
+static constexpr std::array<std::string_view, DEFAULT_SLOTS> buildDefault()
+{
+    std::array<std::string_view, DEFAULT_SLOTS> slots{};
+    for (size_t i = 0; i < DEFAULT_COUNT; i++)
+    {
+        StopWords::place(slots.data(), DEFAULT_SLOTS - 1, DEFAULT_WORDS[i]);
+    }
+    return slots;
+}
+
+// Length of the longest built-in stopword
+static constexpr size_t longestDefault()
+{
+    size_t longest = 0;
+    for (size_t i = 0; i < DEFAULT_COUNT; i++)
+    {
+        longest = DEFAULT_WORDS[i].size() > longest ? DEFAULT_WORDS[i].size() : longest;
+    }
+    return longest;
+}
+
+static constexpr std::array<std::string_view, DEFAULT_SLOTS> DEFAULT_TABLE = buildDefault();
+
+// Number of words that ended up in the built-in table
+static constexpr size_t placedDefault()
+{
+    size_t placed = 0;
+    for (size_t i = 0; i < DEFAULT_SLOTS; i++)
+    {
+        placed += !DEFAULT_TABLE[i].empty();
+    }
+    return placed;
+}
+
+static_assert(DEFAULT_COUNT * 3 <= DEFAULT_SLOTS, "the built-in stopword table is too full");
+static_assert(placedDefault() == DEFAULT_COUNT, "the built-in stopword list has a duplicate");
+
+StopWords::StopWords()
+{
+    useDefault();
+}
+
+StopWords::StopWords(const StopWords &rhs)
+{
+    useDefault();
+    *this = rhs;
+}
+
+StopWords::StopWords(StopWords &&rhs) noexcept
+{
+    useDefault();
+    *this = std::move(rhs);
+}
+
+StopWords &StopWords::operator=(const StopWords &rhs)
+{
+    if (this != &rhs)
+    {
+        if (rhs.table == DEFAULT_TABLE.data())
+        {
+            useDefault();
+        }
+        else
+        {
+            std::vector<std::string_view> words;
+            for (std::string_view word : rhs.custom)
+            {
+                if (!word.empty())
+                {
+                    words.push_back(word);
+                }
+            }
+            build(words);
+        }
+    }
+    return *this;
+}
+
+// The views keep pointing into the moved storage, so the table moves as is; rhs goes back to the built-in list
+StopWords &StopWords::operator=(StopWords &&rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        table = rhs.table;
+        mask = rhs.mask;
+        count = rhs.count;
+        longest = rhs.longest;
+        storage = std::move(rhs.storage);
+        custom = std::move(rhs.custom);
+        rhs.useDefault();
+    }
+    return *this;
+}
+
+void StopWords::useDefault()
+{
+    table = DEFAULT_TABLE.data();
+    mask = DEFAULT_SLOTS - 1;
+    count = DEFAULT_COUNT;
+    longest = longestDefault();
+    storage.reset();
+    custom.clear();
+}
+
+void StopWords::build(const std::vector<std::string_view> &words)
+{
+    // Copy the text first, so the views stored in the table never move
+    size_t bytes = 0;
+    for (std::string_view word : words)
+    {
+        bytes += word.size();
+    }
+    std::unique_ptr<char[]> text(new char[bytes]);
+    std::vector<std::string_view> copies;
+    copies.reserve(words.size());
+    char *out = text.get();
+    for (std::string_view word : words)
+    {
+        std::copy(word.begin(), word.end(), out);
+        copies.emplace_back(out, word.size());
+        out += word.size();
+    }
+
+    size_t slots = 16;
+    while (slots < words.size() * 3)
+    {
+        slots *= 2;
+    }
+    std::vector<std::string_view> newTable(slots);
+    count = 0;
+    longest = 0;
+    for (std::string_view word : copies)
+    {
+        if (place(newTable.data(), slots - 1, word))
+        {
+            count++;
+            longest = std::max(longest, word.size());
+        }
+    }
+    storage = std::move(text);
+    custom = std::move(newTable);
+    table = custom.data();
+    mask = slots - 1;
+}
+
+// Reads a whitespace-separated list of stopwords
+bool StopWords::load(const std::string &path)
+{
+    std::ifstream input(path);
+    if (!input.is_open())
+    {
+        std::cerr << "Could not open stopword list: " << path << std::endl;
+        return false;
+    }
+    std::stringstream text;
+    text << input.rdbuf();
+    assign(text.str());
+    return true;
+}
+
+// Splits text at whitespace and builds the table over the lowercased words
+void StopWords::assign(std::string_view text)
+{
+    std::string lower(text);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    std::vector<std::string_view> words;
+    size_t end = 0;
+    while (true)
+    {
+        size_t start = lower.find_first_not_of(" \t\n\v\f\r", end);
+        if (start == std::string::npos)
+        {
+            break;
+        }
+        end = std::min(lower.find_first_of(" \t\n\v\f\r", start), lower.size());
+        words.emplace_back(lower.data() + start, end - start);
+    }
+    build(words);
+}
+
+// Collects the occupied slots of whichever table is in use
+std::string StopWords::text() const
+{
+    std::string out;
+    for (size_t slot = 0; slot <= mask; slot++)
+    {
+        if (!table[slot].empty())
+        {
+            out.append(table[slot]).push_back('\n');
+        }
+    }
+    return out;
+}
@@ -0,0 +1,105 @@
+#ifndef STOPWORDS_H
+#define STOPWORDS_H
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Set of words that are left out of the index, probed with a string_view so checking a token allocates nothing.
+//
+// The words sit in an open-addressing hash table of string_views (linear probing, an empty view marks a free
+// slot, at most a third of the slots used). The built-in English list is hashed into its table at compile time;
+// a custom list loaded at startup is hashed into a table of the same layout and probed by the same code. Words
+// longer than the longest stopword are rejected before hashing.
+class StopWords
+{
+private:
+    const std::string_view *table; // The slots probed: the built-in table or custom
+    size_t mask;                   // Number of slots - 1, a power of two minus one
+    size_t count;                  // Number of words in the table
+    size_t longest;                // Length of the longest word in the table
+
+    std::unique_ptr<char[]> storage;      // Text of a loaded list; the views in custom point into it
+    std::vector<std::string_view> custom; // Slots of a loaded list
+
+    // Uses the built-in list
+    void useDefault();
+
+    // Builds the custom table over a copy of words
+    void build(const std::vector<std::string_view> &words);
+
+public:
+    // FNV-1a hash of a word
+    static constexpr uint64_t hash(std::string_view word)
+    {
+        uint64_t h = 14695981039346656037ull;
+        for (char c : word)
+        {
+            h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    // Puts word into a table with mask + 1 slots; returns false if it was already there
+    static constexpr bool place(std::string_view *slots, size_t mask, std::string_view word)
+    {
+        size_t slot = hash(word) & mask;
+        while (!slots[slot].empty())
+        {
+            if (slots[slot] == word)
+            {
+                return false;
+            }
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = word;
+        return true;
+    }
+
+    // The built-in English stopword list
+    StopWords();
+
+    StopWords(const StopWords &);
+    StopWords(StopWords &&) noexcept;
+    StopWords &operator=(const StopWords &);
+    StopWords &operator=(StopWords &&) noexcept;
+
+    // Replaces the list with the words of a file (separated by whitespace, lowercased). Words are compared with
+    // stemmed tokens, like the built-in list. Returns false and keeps the current list if the file cannot be read
+    bool load(const std::string &path);
+
+    // Replaces the list with the words of text, separated by whitespace and lowercased like a loaded file
+    void assign(std::string_view text);
+
+    // The words of the list, one per line in no particular order, the way an index file stores them
+    std::string text() const;
+
+    // Check if a word is in the list
+    bool contains(std::string_view word) const
+    {
+        if (word.empty() || word.size() > longest)
+        {
+            return false;
+        }
+        for (size_t slot = hash(word) & mask;; slot = (slot + 1) & mask)
+        {
+            if (table[slot].empty())
+            {
+                return false;
+            }
+            if (table[slot] == word)
+            {
+                return true;
+            }
+        }
+    }
+
+    // Number of words in the list
+    size_t size() const
+    {
+        return count;
+    }
+};
+#endif
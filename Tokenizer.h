@@ -0,0 +1,77 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Splits text into whitespace-separated tokens and normalizes each one in a single pass: ASCII letters are kept
+// and lowercased, everything else is dropped. The text is scanned in place (e.g. the string buffer of a parsed
+// JSON document), and the normalized token is written into a scratch buffer that is reused for every token, so
+// once the buffer has grown to the longest token no memory is allocated. A token without letters normalizes to
+// the empty string; it is still reported, so callers count it like any other token.
+class Tokenizer
+{
+private:
+    const char *pos;     // Next character to scan
+    const char *end;     // One past the last character of the text
+    std::string scratch; // The current normalized token
+
+    // Whitespace as istream's >> sees it in the "C" locale
+    static bool isSpace(char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    // The lowercase letter for an ASCII letter, 0 for any other character
+    static char lowercase(char c)
+    {
+        char lower = c | 0x20; // Sets the case bit, which maps 'A'..'Z' onto 'a'..'z'
+        return lower >= 'a' && lower <= 'z' ? lower : 0;
+    }
+
+public:
+    Tokenizer(const char *text, size_t length) : pos{text}, end{text + length} {}
+    Tokenizer(std::string_view text) : Tokenizer(text.data(), text.size()) {}
+
+    // Moves to the next token and returns false once the text is exhausted
+    bool next()
+    {
+        while (pos != end && isSpace(*pos))
+        {
+            ++pos;
+        }
+        if (pos == end)
+        {
+            return false;
+        }
+        const char *start = pos;
+        while (pos != end && !isSpace(*pos))
+        {
+            ++pos;
+        }
+        scratch.resize(pos - start); // Room for every character; only reallocates for a token longer than any before
+        char *out = &scratch[0];
+        for (const char *c = start; c != pos; ++c)
+        {
+            char letter = lowercase(*c);
+            *out = letter;
+            out += letter != 0; // Overwritten by the next letter unless this one was kept
+        }
+        scratch.resize(out - scratch.data());
+        return true;
+    }
+
+    // The current normalized token; valid until the next call to next()
+    std::string_view token() const
+    {
+        return scratch;
+    }
+
+    // The scratch buffer holding the current token, for in-place processing such as stemming. Its contents are
+    // replaced by the next call to next()
+    std::string &buffer()
+    {
+        return scratch;
+    }
+};
+#endif
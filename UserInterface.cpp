@@ -1,5 +1,15 @@
 #include "UserInterface.h"
 
+// Binds the QueryProcessor once per index snapshot instead of before every query
+void UserInterface::setIndex(std::shared_ptr<const IndexHandler> index)
+{
+    ih = index;
+    if (ih)
+    {
+        qp.setIndexHandler(ih);
+    }
+}
+
 // Function to handle the initial question and options for the user interface
 void UserInterface::initialQuestion()
 {
@@ -40,7 +50,7 @@ void UserInterface::initialQuestion()
             auto startTrain = std::chrono::high_resolution_clock::now(); // Start timing the operation
             std::cout << "Reading files..." << std::endl;
             dp.traverseSubdirectory(answer2); // Traverse the directory and index documents
-            ih = dp.getIndex();               // Update the index handler with the new index
+            setIndex(dp.releaseIndex());      // Take the new index over from the document parser
             std::cout << "Done!" << std::endl;
             auto finishTrain = std::chrono::high_resolution_clock::now(); // End timing the operation
             elapsedTrain = finishTrain - startTrain;                      // Calculate the time taken
@@ -50,8 +60,12 @@ void UserInterface::initialQuestion()
         {
             std::cout << "Generating persistence, this may take a moment..." << std::endl;
             auto startTrain = std::chrono::high_resolution_clock::now(); // Start timing the operation
-            ih = dp.getIndex();                                          // Retrieve the current index
-            ih.createPersistence();                                      // Create a persistent representation of the index
+            if (!ih)
+            {
+                std::cout << "Please create an index first." << std::endl;
+                continue;
+            }
+            ih->createPersistence(); // Create a persistent representation of the index
             std::cout << "Persistence was created!" << std::endl;
             auto finishTrain = std::chrono::high_resolution_clock::now(); // End timing the operation
             elapsedTrain = finishTrain - startTrain;                      // Calculate the time taken
@@ -61,8 +75,7 @@ void UserInterface::initialQuestion()
         {
             std::cout << "Reading persistence..." << std::endl;
             auto startTrain = std::chrono::high_resolution_clock::now(); // Start timing the operation
-            ih.readPersistence();                                        // Read the index from persistence
-            dp.setIndex(ih);                                             // Set the index for the document parser
+            setIndex(IndexHandler::openPersistence());                   // Read the index from persistence
             std::cout << "Persistence has been read!" << std::endl;
             auto finishTrain = std::chrono::high_resolution_clock::now(); // End timing the operation
             elapsedTrain = finishTrain - startTrain;                      // Calculate the time taken
@@ -70,23 +83,27 @@ void UserInterface::initialQuestion()
         // Option 4: Enter and process a search query
         else if (answer == "4")
         {
-            qp.setIndexHandler(ih); // Set the IndexHandler in QueryProcessor to the current IndexHandler
+            if (!ih)
+            {
+                std::cout << "Please create an index first." << std::endl;
+                continue;
+            }
             std::cout << "Please enter a query" << std::endl;
             std::string answer3;
             std::getline(std::cin, answer3); // Get the user's query as input
 
-            auto startTrain = std::chrono::high_resolution_clock::now();         // Start timing the query processing
-            std::map<std::string, int> relevantDocs = qp.parsingAnswer(answer3); // Process the query and get relevant documents
+            auto startTrain = std::chrono::high_resolution_clock::now(); // Start timing the query processing
+            qp.parsingAnswer(answer3);                                   // Process the query and collect the relevant documents
 
             // Display the relevant documents if there are any
             if (qp.getPrintVectorSize() >= 1)
             {
                 int count = 1;
                 std::cout << "Here are the most relevant documents" << std::endl;
-                for (const auto &item : qp.getPrintVector())
+                for (DocId id : qp.getResultIds())
                 {
                     std::cout << count << ". ";
-                    dp.printInfo(item); // Print information for each relevant document
+                    dp.printInfo(*ih, id); // Print information for each relevant document, from the index
                     std::cout << std::endl;
                     ++count;
                 }
@@ -119,8 +136,8 @@ void UserInterface::initialQuestion()
         {
             std::cout << "Here are some of our runtime statistics:" << std::endl;
             std::cout << "Runtime: " << elapsedTrain.count() << " seconds." << std::endl;          // Display the elapsed time for the last operation
-            std::cout << "Total articles: " << ih.getDocSize() << std::endl;                       // Display the total number of articles in the index
-            std::cout << "Total number of unique words indexed: " << ih.returnSize() << std::endl; // Display the number of unique words indexed
+            std::cout << "Total articles: " << (ih ? ih->getDocSize() : 0) << std::endl;                       // Display the total number of articles in the index
+            std::cout << "Total number of unique words indexed: " << (ih ? ih->returnSize() : 0) << std::endl; // Display the number of unique words indexed
         }
         // Option 6: Quit the program
         else if (answer == "6")
@@ -15,13 +15,16 @@ class UserInterface
 private:
     // Private member variables
     std::chrono::duration<double> elapsedTrain; // Variable to track time duration, possibly for performance measurement
-    IndexHandler ih;                            // An instance of IndexHandler for handling indexing operations
+    std::shared_ptr<const IndexHandler> ih;     // The current index, shared with the QueryProcessor
     QueryProcessor qp;                          // An instance of QueryProcessor for processing user queries
     DocumentParser dp;                          // An instance of DocumentParser for parsing documents
 
 public:
     // Public member function
 
+    // Sets the current index and binds the QueryProcessor to it; called whenever the index is replaced
+    void setIndex(std::shared_ptr<const IndexHandler> index);
+
     // Function to initiate and handle the initial user interaction
     void initialQuestion(); // Method to ask the initial question or provide options to the user
 };
@@ -34,6 +34,7 @@
 #include <utility>
 #include <iostream>
 #include <sstream>
+#include <string_view>
 #include <unordered_map>
 #include "porter2_stemmer.h"
 
@@ -513,6 +514,10 @@ bool Porter2Stemmer::internal::replaceIfExists(std::string& word,
                                                const std::string& replacement,
                                                size_t start)
 {
+    // a suffix longer than the word never matches (idx would wrap around)
+    if (suffix.size() > word.size())
+        return false;
+
     size_t idx = word.size() - suffix.size();
     if (idx < start)
         return false;
@@ -542,3 +547,407 @@ bool Porter2Stemmer::internal::containsVowel(const std::string& word,
     }
     return false;
 }
+
+/*
+  In-place variant of stem(std::string&): the same steps, applied to the
+  caller's buffer. Suffixes are compared through string_views and replaced by
+  overwriting the tail of the buffer (every replacement is at most as long as
+  the suffix it replaces), so no step allocates.
+*/
+namespace
+{
+using Porter2Stemmer::internal::isVowel;
+using Porter2Stemmer::internal::isVowelY;
+using Porter2Stemmer::internal::isValidLIEnding;
+
+// A word being stemmed: the caller's buffer and its current length
+struct Buffer
+{
+    char* s;
+    size_t n;
+};
+
+struct Sub
+{
+    std::string_view suffix;
+    std::string_view replacement;
+};
+
+bool equals(const Buffer& word, std::string_view str)
+{
+    return word.n == str.size() && std::equal(str.begin(), str.end(), word.s);
+}
+
+// Comparing the last letter first rejects most suffixes without a call to memcmp
+bool endsWith(const Buffer& word, std::string_view str)
+{
+    return word.n >= str.size() && word.s[word.n - 1] == str.back()
+           && std::equal(str.begin(), str.end(), word.s + (word.n - str.size()));
+}
+
+// A suffix longer than the word never matches
+bool replaceIfExists(Buffer& word, std::string_view suffix,
+                     std::string_view replacement, size_t start)
+{
+    if (suffix.size() > word.n)
+        return false;
+
+    size_t idx = word.n - suffix.size();
+    if (idx < start)
+        return false;
+
+    if (endsWith(word, suffix))
+    {
+        std::copy(replacement.begin(), replacement.end(), word.s + idx);
+        word.n = idx + replacement.size();
+        return true;
+    }
+    return false;
+}
+
+template <size_t N>
+bool replaceFirst(Buffer& word, const Sub (&subs)[N], size_t start)
+{
+    for (const Sub& sub : subs)
+        if (replaceIfExists(word, sub.suffix, sub.replacement, start))
+            return true;
+    return false;
+}
+
+bool containsVowel(const Buffer& word, size_t start, size_t end)
+{
+    if (end <= word.n)
+    {
+        for (size_t i = start; i < end; ++i)
+            if (isVowelY(word.s[i]))
+                return true;
+    }
+    return false;
+}
+
+size_t firstNonVowelAfterVowel(const Buffer& word, size_t start)
+{
+    for (size_t i = start; i != 0 && i < word.n; ++i)
+    {
+        if (!isVowelY(word.s[i]) && isVowelY(word.s[i - 1]))
+            return i + 1;
+    }
+
+    return word.n;
+}
+
+size_t getStartR1(const Buffer& word)
+{
+    // special cases
+    Buffer prefix5{word.s, std::min<size_t>(word.n, 5)};
+    Buffer prefix6{word.s, std::min<size_t>(word.n, 6)};
+    if (equals(prefix5, "gener") || equals(prefix5, "arsen"))
+        return 5;
+    if (equals(prefix6, "commun"))
+        return 6;
+
+    // general case
+    return firstNonVowelAfterVowel(word, 1);
+}
+
+size_t getStartR2(const Buffer& word, size_t startR1)
+{
+    if (startR1 == word.n)
+        return startR1;
+
+    return firstNonVowelAfterVowel(word, startR1 + 1);
+}
+
+void changeY(Buffer& word)
+{
+    if (word.s[0] == 'y')
+        word.s[0] = 'Y';
+
+    for (size_t i = 1; i < word.n; ++i)
+    {
+        if (word.s[i] == 'y' && isVowel(word.s[i - 1]))
+            word.s[i++] = 'Y'; // skip next iteration
+    }
+}
+
+bool isShort(const char* word, size_t size)
+{
+    if (size >= 3)
+    {
+        if (!isVowelY(word[size - 3]) && isVowelY(word[size - 2])
+            && !isVowelY(word[size - 1]) && word[size - 1] != 'w'
+            && word[size - 1] != 'x' && word[size - 1] != 'Y')
+            return true;
+    }
+    return size == 2 && isVowelY(word[0]) && !isVowelY(word[1]);
+}
+
+bool endsInDouble(const Buffer& word)
+{
+    if (word.n >= 2)
+    {
+        char a = word.s[word.n - 1];
+        char b = word.s[word.n - 2];
+
+        if (a == b)
+            return a == 'b' || a == 'd' || a == 'f' || a == 'g' || a == 'm'
+                   || a == 'n' || a == 'p' || a == 'r' || a == 't';
+    }
+
+    return false;
+}
+
+bool special(Buffer& word)
+{
+    static constexpr Sub exceptions[] = {{"skis", "ski"},
+                                         {"skies", "sky"},
+                                         {"dying", "die"},
+                                         {"lying", "lie"},
+                                         {"tying", "tie"},
+                                         {"idly", "idl"},
+                                         {"gently", "gentl"},
+                                         {"ugly", "ugli"},
+                                         {"early", "earli"},
+                                         {"only", "onli"},
+                                         {"singly", "singl"}};
+
+    // special cases
+    for (const Sub& ex : exceptions)
+    {
+        if (equals(word, ex.suffix))
+        {
+            std::copy(ex.replacement.begin(), ex.replacement.end(), word.s);
+            word.n = ex.replacement.size();
+            return true;
+        }
+    }
+
+    // invariants
+    return equals(word, "sky") || equals(word, "news") || equals(word, "howe")
+           || equals(word, "atlas") || equals(word, "cosmos")
+           || equals(word, "bias") || equals(word, "andes");
+}
+
+void step0(Buffer& word)
+{
+    // short circuit the longest suffix
+    replaceIfExists(word, "'s'", "", 0) || replaceIfExists(word, "'s", "", 0)
+        || replaceIfExists(word, "'", "", 0);
+}
+
+bool step1A(Buffer& word)
+{
+    if (!replaceIfExists(word, "sses", "ss", 0))
+    {
+        if (endsWith(word, "ied") || endsWith(word, "ies"))
+        {
+            // if preceded by only one letter
+            word.n -= word.n <= 4 ? 1 : 2;
+        }
+        else if (endsWith(word, "s") && !endsWith(word, "us")
+                 && !endsWith(word, "ss"))
+        {
+            if (word.n > 2 && containsVowel(word, 0, word.n - 2))
+                --word.n;
+        }
+    }
+
+    // special case after step 1a
+    return equals(word, "inning") || equals(word, "outing")
+           || equals(word, "canning") || equals(word, "herring")
+           || equals(word, "earring") || equals(word, "proceed")
+           || equals(word, "exceed") || equals(word, "succeed");
+}
+
+void step1B(Buffer& word, size_t startR1)
+{
+    bool exists = endsWith(word, "eedly") || endsWith(word, "eed");
+
+    if (exists) // look only in startR1 now
+        replaceIfExists(word, "eedly", "ee", startR1)
+            || replaceIfExists(word, "eed", "ee", startR1);
+    else
+    {
+        size_t size = word.n;
+        bool deleted = (containsVowel(word, 0, size - 2)
+                        && replaceIfExists(word, "ed", "", 0))
+                       || (containsVowel(word, 0, size - 4)
+                           && replaceIfExists(word, "edly", "", 0))
+                       || (containsVowel(word, 0, size - 3)
+                           && replaceIfExists(word, "ing", "", 0))
+                       || (containsVowel(word, 0, size - 5)
+                           && replaceIfExists(word, "ingly", "", 0));
+
+        // The suffix just deleted leaves room for the e
+        if (deleted && (endsWith(word, "at") || endsWith(word, "bl")
+                        || endsWith(word, "iz")))
+            word.s[word.n++] = 'e';
+        else if (deleted && endsInDouble(word))
+            --word.n;
+        else if (deleted && startR1 == word.n && isShort(word.s, word.n))
+            word.s[word.n++] = 'e';
+    }
+}
+
+void step1C(Buffer& word)
+{
+    size_t size = word.n;
+    if (size > 2 && (word.s[size - 1] == 'y' || word.s[size - 1] == 'Y'))
+        if (!isVowel(word.s[size - 2]))
+            word.s[size - 1] = 'i';
+}
+
+void step2(Buffer& word, size_t startR1)
+{
+    static constexpr Sub subs[] = {{"ational", "ate"},
+                                   {"tional", "tion"},
+                                   {"enci", "ence"},
+                                   {"anci", "ance"},
+                                   {"abli", "able"},
+                                   {"entli", "ent"},
+                                   {"izer", "ize"},
+                                   {"ization", "ize"},
+                                   {"ation", "ate"},
+                                   {"ator", "ate"},
+                                   {"alism", "al"},
+                                   {"aliti", "al"},
+                                   {"alli", "al"},
+                                   {"fulness", "ful"},
+                                   {"ousli", "ous"},
+                                   {"ousness", "ous"},
+                                   {"iveness", "ive"},
+                                   {"iviti", "ive"},
+                                   {"biliti", "ble"},
+                                   {"bli", "ble"},
+                                   {"fulli", "ful"},
+                                   {"lessli", "less"}};
+
+    if (replaceFirst(word, subs, startR1))
+        return;
+
+    if (!replaceIfExists(word, "logi", "log", startR1 - 1))
+    {
+        // make sure we choose the longest suffix
+        if (endsWith(word, "li") && !endsWith(word, "abli")
+            && !endsWith(word, "entli") && !endsWith(word, "aliti")
+            && !endsWith(word, "alli") && !endsWith(word, "ousli")
+            && !endsWith(word, "bli") && !endsWith(word, "fulli")
+            && !endsWith(word, "lessli"))
+            if (word.n > 3 && word.n - 2 >= startR1
+                && isValidLIEnding(word.s[word.n - 3]))
+                word.n -= 2;
+    }
+}
+
+void step3(Buffer& word, size_t startR1, size_t startR2)
+{
+    static constexpr Sub subs[] = {{"ational", "ate"},
+                                   {"tional", "tion"},
+                                   {"alize", "al"},
+                                   {"icate", "ic"},
+                                   {"iciti", "ic"},
+                                   {"ical", "ic"},
+                                   {"ful", ""},
+                                   {"ness", ""}};
+
+    if (replaceFirst(word, subs, startR1))
+        return;
+
+    replaceIfExists(word, "ative", "", startR2);
+}
+
+void step4(Buffer& word, size_t startR2)
+{
+    static constexpr Sub subs[] = {{"al", ""},
+                                   {"ance", ""},
+                                   {"ence", ""},
+                                   {"er", ""},
+                                   {"ic", ""},
+                                   {"able", ""},
+                                   {"ible", ""},
+                                   {"ant", ""},
+                                   {"ement", ""},
+                                   {"ment", ""},
+                                   {"ism", ""},
+                                   {"ate", ""},
+                                   {"iti", ""},
+                                   {"ous", ""},
+                                   {"ive", ""},
+                                   {"ize", ""}};
+
+    if (replaceFirst(word, subs, startR2))
+        return;
+
+    // make sure we only choose the longest suffix
+    if (!endsWith(word, "ement") && !endsWith(word, "ment"))
+        if (replaceIfExists(word, "ent", "", startR2))
+            return;
+
+    // short circuit
+    replaceIfExists(word, "sion", "s", startR2 - 1)
+        || replaceIfExists(word, "tion", "t", startR2 - 1);
+}
+
+void step5(Buffer& word, size_t startR1, size_t startR2)
+{
+    size_t size = word.n;
+    if (size == 0) // only a word made of quotes gets here empty
+        return;
+    if (word.s[size - 1] == 'e')
+    {
+        if (size - 1 >= startR2)
+            --word.n;
+        else if (size - 1 >= startR1 && !isShort(word.s, size - 1))
+            --word.n;
+    }
+    else if (word.s[size - 1] == 'l')
+    {
+        if (size >= 2 && size - 1 >= startR2 && word.s[size - 2] == 'l')
+            --word.n;
+    }
+}
+}
+
+size_t Porter2Stemmer::stem(char* word, size_t length)
+{
+    Buffer w{word, length};
+
+    // special case short words or sentence tags
+    if (w.n <= 2 || equals(w, "<s>") || equals(w, "</s>"))
+        return w.n;
+
+    // max word length is 35 for English
+    if (w.n > 35)
+        w.n = 35;
+
+    if (w.s[0] == '\'')
+    {
+        std::copy(w.s + 1, w.s + w.n, w.s);
+        --w.n;
+    }
+
+    if (special(w))
+        return w.n;
+
+    changeY(w);
+    size_t startR1 = getStartR1(w);
+    size_t startR2 = getStartR2(w, startR1);
+
+    step0(w);
+
+    if (step1A(w))
+    {
+        std::replace(w.s, w.s + w.n, 'Y', 'y');
+        return w.n;
+    }
+
+    step1B(w, startR1);
+    step1C(w);
+    step2(w, startR1);
+    step3(w, startR1, startR2);
+    step4(w, startR2);
+    step5(w, startR1, startR2);
+
+    std::replace(w.s, w.s + w.n, 'Y', 'y');
+    return w.n;
+}
@@ -39,6 +39,14 @@ void stem(std::string& word);
 
 void trim(std::string& word);
 
+/**
+ * Stems the length characters at word in place, without allocating, and
+ * returns the length of the stem. The stem is never longer than the word
+ * (nor than 35 characters) and is byte-identical to what
+ * stem(std::string&) produces for the same word.
+ */
+size_t stem(char* word, size_t length);
+
 namespace internal
 {
 size_t firstNonVowelAfterVowel(const std::string& word, size_t start);
@@ -0,0 +1,123 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "BPlusTree.h"
+#include <map>
+#include <random>
+#include <string>
+
+// Test suite for the 'insert', 'find' and 'contains' functions of the BPlusTree class
+TEST_CASE("insert and find", "[BPlusTree]")
+{
+    BPlusTree<std::string, int> test1;
+    REQUIRE(test1.isEmpty());
+    REQUIRE(test1.find("HELLO!") == nullptr);
+    test1.insert("HELLO!", 4);
+    test1.insert("HI", 4);
+    test1.insert("HELLO!", 5, 3);
+    REQUIRE(test1.getSize() == 2);
+    REQUIRE(test1.contains("HI"));
+    REQUIRE(test1.contains("hola") == false);
+    REQUIRE(test1.find("HELLO!")->getFrequency(5) == 3);
+
+    // Enough keys for several levels of inner nodes
+    BPlusTree<int, int> test2;
+    for (int i = 0; i < 5000; i++)
+    {
+        test2.insert((i * 7919) % 5000, i); // every key once, in scrambled order
+    }
+    REQUIRE(test2.getSize() == 5000);
+    for (int i = 0; i < 5000; i++)
+    {
+        REQUIRE(test2.contains(i));
+    }
+    REQUIRE(test2.contains(5000) == false);
+    REQUIRE(test2.contains(-1) == false);
+}
+
+// Test suite for the ordered scans of the BPlusTree class
+TEST_CASE("forEach and forEachInRange", "[BPlusTree]")
+{
+    BPlusTree<int, int> test1;
+    for (int i = 999; i >= 0; i--)
+    {
+        test1.insert(i * 2, i); // even keys only
+    }
+
+    int previous = -1, count = 0;
+    test1.forEach([&](const int &key, const PostingList<int> &)
+                  {
+                      REQUIRE(previous < key);
+                      previous = key;
+                      count++; });
+    REQUIRE(count == 1000);
+
+    std::vector<int> range;
+    test1.forEachInRange(101, 121, [&range](const int &key, const PostingList<int> &)
+                         { range.push_back(key); });
+    REQUIRE(range == std::vector<int>{102, 104, 106, 108, 110, 112, 114, 116, 118, 120});
+
+    // A prefix is the range [prefix, next prefix)
+    BPlusTree<std::string, int> test2;
+    for (std::string word : {"state", "stat", "static", "station", "stay", "star", "stem", "sta"})
+    {
+        test2.insert(word, 1);
+    }
+    std::vector<std::string> prefixed;
+    test2.forEachInRange("stat", "stau", [&prefixed](const std::string &key, const PostingList<int> &)
+                         { prefixed.push_back(key); });
+    REQUIRE(prefixed == std::vector<std::string>{"stat", "state", "static", "station"});
+}
+
+// Test suite for copying, moving and merging BPlusTree objects
+TEST_CASE("copy, move and merge", "[BPlusTree]")
+{
+    BPlusTree<std::string, int> original;
+    original.insert("HELLO!", 4);
+    original.insert("HI", 4);
+
+    BPlusTree<std::string, int> copy = original;
+    copy.insert("bye", 10);
+    REQUIRE(copy.getSize() == 3);
+    REQUIRE(original.contains("bye") == false);
+
+    BPlusTree<std::string, int> moved = std::move(copy);
+    REQUIRE(moved.getSize() == 3);
+    REQUIRE(copy.getSize() == 0);
+
+    original.merge(moved, [](int v)
+                   { return v + 1; });
+    original.finalize();
+    REQUIRE(original.getSize() == 3);
+    REQUIRE(original.find("HI")->size() == 2);
+    REQUIRE(original.find("HI")->getId(1) == 5);
+
+    original.makeEmpty();
+    REQUIRE(original.isEmpty());
+    REQUIRE(original.find("HI") == nullptr);
+}
+
+// Randomised comparison against std::map
+TEST_CASE("matches std::map", "[BPlusTree]")
+{
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> keys(0, 30000);
+    BPlusTree<std::string, int> tree;
+    std::map<std::string, int> expected;
+    for (int i = 0; i < 60000; i++)
+    {
+        std::string key = "k" + std::to_string(keys(rng));
+        tree.insert(key, i);
+        expected[key]++;
+    }
+    tree.finalize();
+    REQUIRE(tree.getSize() == (int)expected.size());
+
+    auto itr = expected.begin();
+    bool inOrder = true;
+    tree.forEach([&](const std::string &key, const PostingList<int> &postings)
+                 {
+                     inOrder = inOrder && itr != expected.end() && key == itr->first && (int)postings.size() == itr->second;
+                     ++itr; });
+    REQUIRE(inOrder);
+    REQUIRE(itr == expected.end());
+}
@@ -0,0 +1,190 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "BlockCodec.h"
+#include "PostingList.h"
+#include <random>
+#include <sstream>
+#include <vector>
+
+// Random ascending, duplicate-free document IDs below limit, each kept with the given probability, and random
+// frequencies that are mostly 1
+static void randomList(std::mt19937 &rng, DocId limit, double probability, std::vector<DocId> &ids, std::vector<int> &freqs)
+{
+    std::bernoulli_distribution keep(probability);
+    std::geometric_distribution<int> extra(0.6);
+    ids.clear();
+    freqs.clear();
+    for (DocId id = 0; id < limit; id++)
+    {
+        if (keep(rng))
+        {
+            ids.push_back(id);
+            freqs.push_back(1 + extra(rng));
+        }
+    }
+}
+
+// A finalized (compressed) posting list with the given entries
+static PostingList<DocId> compressedList(const std::vector<DocId> &ids, const std::vector<int> &freqs)
+{
+    PostingList<DocId> list;
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        list.add(ids[i], freqs[i]);
+    }
+    list.finalize();
+    return list;
+}
+
+// Test case for encoding and decoding lists of every shape
+TEST_CASE("round trip", "[BlockCodec]")
+{
+    std::mt19937 rng(42);
+    std::vector<DocId> ids;
+    std::vector<int> freqs;
+    const double densities[] = {0.0005, 0.01, 0.3, 1.0};
+    for (double density : densities)
+    {
+        for (DocId limit : {1u, 127u, 128u, 129u, 1000u, 50000u})
+        {
+            randomList(rng, limit, density, ids, freqs);
+            std::vector<uint8_t> bytes;
+            BlockCodec::encode(ids.data(), freqs.data(), ids.size(), bytes);
+            PostingView<DocId> view(bytes.data(), bytes.size(), ids.size());
+
+            std::vector<DocId> decodedIds;
+            std::vector<int> decodedFreqs;
+            view.forEach([&](DocId id, int freq)
+                         {
+                             decodedIds.push_back(id);
+                             decodedFreqs.push_back(freq); });
+            REQUIRE(decodedIds == ids);
+            REQUIRE(decodedFreqs == freqs);
+            for (size_t b = 0; b < view.blockCount(); b++)
+            {
+                REQUIRE(view.blockLast(b) == ids[std::min(ids.size(), (b + 1) * BlockCodec::BLOCK_SIZE) - 1]);
+            }
+            for (size_t i = 0; i < ids.size(); i += 7)
+            {
+                REQUIRE(view.getFrequency(ids[i]) == freqs[i]);
+            }
+        }
+    }
+
+    // Extreme values: the largest IDs, the largest gaps and frequencies
+    ids = {0, 1, 2, 0x7fffffffu, 0xfffffffeu, 0xffffffffu};
+    freqs = {1, 0x7fffffff, 3, 1, 2, 1};
+    std::vector<uint8_t> bytes;
+    BlockCodec::encode(ids.data(), freqs.data(), ids.size(), bytes);
+    PostingView<DocId> view(bytes.data(), bytes.size(), ids.size());
+    DocId outIds[BlockCodec::BLOCK_SIZE];
+    int outFreqs[BlockCodec::BLOCK_SIZE];
+    REQUIRE(view.decodeBlock(0, outIds, outFreqs) == ids.size());
+    REQUIRE(std::vector<DocId>(outIds, outIds + ids.size()) == ids);
+    REQUIRE(std::vector<int>(outFreqs, outFreqs + ids.size()) == freqs);
+
+    // Blocks spread over the whole ID range, packed at every width up to 32 bits: full ones, shorter last blocks
+    // in lanes, and the longest last block still packed as a stream
+    for (size_t length : {BlockCodec::BLOCK_SIZE, size_t(101), BlockCodec::LANE_MIN + 1, BlockCodec::LANE_MIN, BlockCodec::LANE_MIN - 1})
+    {
+        ids.clear();
+        freqs.clear();
+        for (size_t i = 0; i < length; i++)
+        {
+            ids.push_back(DocId(i * 0x2000000u + (i * i) % 0x2000000u));
+            freqs.push_back(int((uint32_t(i * 2654435761u) >> (i % 31 + 1)) | 1));
+        }
+        ids.back() = 0xffffffffu;
+        bytes.clear();
+        BlockCodec::encode(ids.data(), freqs.data(), ids.size(), bytes);
+        view = PostingView<DocId>(bytes.data(), bytes.size(), ids.size());
+        REQUIRE(view.decodeBlock(0, outIds, outFreqs) == ids.size());
+        REQUIRE(std::vector<DocId>(outIds, outIds + ids.size()) == ids);
+        REQUIRE(std::vector<int>(outFreqs, outFreqs + ids.size()) == freqs);
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            REQUIRE(view.getFrequency(ids[i]) == freqs[i]);
+        }
+    }
+}
+
+// Test case for compressing posting lists in finalize() and adding to them afterwards
+TEST_CASE("compressed posting lists", "[BlockCodec]")
+{
+    std::mt19937 rng(7);
+    std::vector<DocId> ids;
+    std::vector<int> freqs;
+    randomList(rng, 20000, 0.2, ids, freqs);
+    PostingList<DocId> list = compressedList(ids, freqs);
+    REQUIRE(list.compressed());
+    REQUIRE(list.size() == ids.size());
+    REQUIRE(list.getFrequency(ids[100]) == freqs[100]);
+    REQUIRE(list.getFrequency(ids.back() + 1) == 0);
+
+    // A compressed list is at least 3 times smaller than the plain arrays
+    size_t plainBytes = ids.size() * (sizeof(DocId) + sizeof(int));
+    REQUIRE(list.view().packedBytes() * 3 < plainBytes);
+
+    // New entries go back to the plain form until the next finalize()
+    list.add(ids.back() + 5, 2);
+    REQUIRE_FALSE(list.compressed());
+    REQUIRE(list.size() == ids.size() + 1);
+    REQUIRE(list.getFrequency(ids.back() + 5) == 2);
+    list.finalize();
+    REQUIRE(list.compressed());
+    REQUIRE(list.getFrequency(ids.back() + 5) == 2);
+    REQUIRE(list.getFrequency(ids[0]) == freqs[0]);
+
+    // Printing, which every dictionary does for its keys' lists, decodes the compressed entries
+    std::ostringstream expected, printed;
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        expected << ids[i] << "," << freqs[i] << ";";
+    }
+    expected << ids.back() + 5 << ",2;";
+    list.print(printed);
+    REQUIRE(printed.str() == expected.str());
+}
+
+// Test case for the per-block score bound statistics kept in the headers
+TEST_CASE("block score bounds", "[BlockCodec]")
+{
+    std::mt19937 rng(11);
+    std::vector<DocId> ids;
+    std::vector<int> freqs;
+    randomList(rng, 5000, 0.3, ids, freqs);
+    std::uniform_int_distribution<int> length(1, 500);
+    std::vector<int> lengths(4000); // The last documents have no known length
+    for (int &l : lengths)
+    {
+        l = length(rng);
+    }
+    PostingList<DocId> list;
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        list.add(ids[i], freqs[i]);
+    }
+    list.finalize(lengths.data(), lengths.size());
+    PostingView<DocId> view = list.view();
+    REQUIRE(view.compressed());
+
+    for (size_t b = 0; b < view.blockCount(); b++)
+    {
+        const size_t first = b * BlockCodec::BLOCK_SIZE, last = first + BlockCodec::blockLength(ids.size(), b);
+        int maxFreq = 0, minLength = INT32_MAX;
+        for (size_t i = first; i < last; i++)
+        {
+            maxFreq = std::max(maxFreq, freqs[i]);
+            minLength = std::min(minLength, ids[i] < lengths.size() ? lengths[ids[i]] : 0);
+        }
+        REQUIRE(view.blockMaxFreq(b) == maxFreq);
+        REQUIRE(view.blockMinLength(b) == minLength);
+    }
+
+    // Without lengths every block falls back to the loosest bound
+    std::vector<uint8_t> bytes;
+    BlockCodec::encode(ids.data(), freqs.data(), ids.size(), bytes);
+    PostingView<DocId> unknown(bytes.data(), bytes.size(), ids.size());
+    REQUIRE(unknown.blockMinLength(0) == 0);
+    REQUIRE(unknown.blockMaxFreq(0) == view.blockMaxFreq(0));
+}
@@ -2,8 +2,8 @@
 #include "catch.hpp"
 #include "DSAvlTree.h"
 
-// Test suite for 'contains' function of the DSAvlTree class
-TEST_CASE("contains", "[DSAvlTree]")
+// Test suite for 'find' function of the DSAvlTree class
+TEST_CASE("find", "[DSAvlTree]")
 {
     // Testing with a string-to-string AVL tree
     DSAvlTree<std::string, std::string> test1;
@@ -11,12 +11,10 @@ TEST_CASE("contains", "[DSAvlTree]")
     test1.insert("HI", "hi");
     test1.insert("hola", "hi");
     // Check if the tree contains specific elements and validate the results
-    std::map<std::string, int> results = test1.contains("hola");
-    REQUIRE(results.size() == 1); // Ensure the size of results is correct
-    std::map<std::string, int>::iterator it = results.find("hola");
-    REQUIRE(it == results.end()); // Check if 'hola' is not found in the results
-    it = results.find("hi");
-    REQUIRE(it != results.end()); // Check if 'hi' is found in the results
+    const PostingList<std::string> *results = test1.find("hola");
+    REQUIRE(results->size() == 1);               // Ensure the size of results is correct
+    REQUIRE(results->getFrequency("hola") == 0); // Check if 'hola' is not found in the results
+    REQUIRE(results->getFrequency("hi") == 1);   // Check if 'hi' is found in the results
 
     // Testing with an int-to-int AVL tree
     DSAvlTree<int, int> test2;
@@ -24,11 +22,15 @@ TEST_CASE("contains", "[DSAvlTree]")
     test2.insert(50, 200);
     test2.insert(600, 200);
     // Check if the tree contains specific elements and validate the results
-    std::map<int, int> results2 = test2.contains(4);
-    REQUIRE(results2.size() == 1); // Ensure the size of results is correct
-    std::map<int, int>::iterator it1 = results2.find(4);
-    REQUIRE(it1 == results2.end()); // Check if '4' is not found in the results
-    REQUIRE(results2[200] == 1);    // Check if '200' is found in the results
+    const PostingList<int> *results2 = test2.find(4);
+    REQUIRE(results2->size() == 1);            // Ensure the size of results is correct
+    REQUIRE(results2->getFrequency(4) == 0);   // Check if '4' is not found in the results
+    REQUIRE(results2->getFrequency(200) == 1); // Check if '200' is found in the results
+
+    // Keys that were never inserted are reported with nullptr
+    REQUIRE(test2.find(5) == nullptr);
+    REQUIRE(test2.contains(5) == false);
+    REQUIRE(test2.contains(50) == true);
 }
 
 // Test suite for 'isEmpty' function of the DSAvlTree class
@@ -86,12 +88,10 @@ TEST_CASE("insert", "[DSAvlTree]")
     test1.insert("HI", "hi");
     test1.insert("hola", "hi");
     // make sure it contains the things that were inserted
-    std::map<std::string, int> results = test1.contains("hola");
-    REQUIRE(results.size() == 1);
-    std::map<std::string, int>::iterator it = results.find("hola");
-    REQUIRE(it == results.end());
-    it = results.find("hi");
-    REQUIRE(it != results.end());
+    const PostingList<std::string> *results = test1.find("hola");
+    REQUIRE(results->size() == 1);
+    REQUIRE(results->getFrequency("hola") == 0);
+    REQUIRE(results->getFrequency("hi") == 1);
 
     DSAvlTree<int, int> test2;
     // insertions
@@ -99,11 +99,10 @@ TEST_CASE("insert", "[DSAvlTree]")
     test2.insert(50, 200);
     test2.insert(600, 200);
     // make sure it contains the things that were inserted
-    std::map<int, int> results2 = test2.contains(4);
-    REQUIRE(results2.size() == 1);
-    std::map<int, int>::iterator it1 = results2.find(4);
-    REQUIRE(it1 == results2.end());
-    REQUIRE(results2[200] == 1);
+    const PostingList<int> *results2 = test2.find(4);
+    REQUIRE(results2->size() == 1);
+    REQUIRE(results2->getFrequency(4) == 0);
+    REQUIRE(results2->getFrequency(200) == 1);
 }
 
 // Test suite for 'remove' function of the DSAvlTree class
@@ -115,15 +114,13 @@ TEST_CASE("remove", "[DSAvlTree]")
     test1.insert("HI", "hi");
     test1.insert("hola", "hi");
     // make sure it contains the things that were inserted
-    std::map<std::string, int> results = test1.contains("hola");
-    REQUIRE(results.size() == 1);
+    const PostingList<std::string> *results = test1.find("hola");
+    REQUIRE(results->size() == 1);
     // make sure find works
-    std::map<std::string, int>::iterator it = results.find("hola");
-    REQUIRE(it == results.end());
-    it = results.find("hi");
-    REQUIRE(it != results.end());
+    REQUIRE(results->getFrequency("hola") == 0);
+    REQUIRE(results->getFrequency("hi") == 1);
     test1.remove("hola");
-    results.erase("hola");
+    REQUIRE(test1.contains("hola") == false);
 
     DSAvlTree<int, int> test2;
     // insertions
@@ -131,14 +128,13 @@ TEST_CASE("remove", "[DSAvlTree]")
     test2.insert(50, 200);
     test2.insert(600, 200);
     // make sure it contains the things that were inserted
-    std::map<int, int> results2 = test2.contains(4);
-    REQUIRE(results2.size() == 1);
+    const PostingList<int> *results2 = test2.find(4);
+    REQUIRE(results2->size() == 1);
     // make sure find works
-    std::map<int, int>::iterator it1 = results2.find(4);
-    REQUIRE(it1 == results2.end());
-    REQUIRE(results2[200] == 1);
+    REQUIRE(results2->getFrequency(4) == 0);
+    REQUIRE(results2->getFrequency(200) == 1);
     test2.remove(4);
-    results2.erase(4);
+    REQUIRE(test2.contains(4) == false);
 }
 
 // Test suite for the copy constructor of the DSAvlTree class
@@ -152,20 +148,16 @@ TEST_CASE("Copy Constructor", "[DSAvlTree]")
     test1.insert("HI", "hi");
     test1.insert("hola", "hi");
     // make sure everything added is in there
-    std::map<std::string, int> results = test1.contains("hola");
-    REQUIRE(results.size() == 1);
-    std::map<std::string, int>::iterator it = results.find("hola");
-    REQUIRE(it == results.end());
-    it = results.find("hi");
-    REQUIRE(it != results.end());
+    const PostingList<std::string> *results = test1.find("hola");
+    REQUIRE(results->size() == 1);
+    REQUIRE(results->getFrequency("hola") == 0);
+    REQUIRE(results->getFrequency("hi") == 1);
     // make sure everything copied
     DSAvlTree<std::string, std::string> copyTree(test1);
-    std::map<std::string, int> results1 = copyTree.contains("hola");
-    REQUIRE(results1.size() == 1);
-    std::map<std::string, int>::iterator it1 = results1.find("hola");
-    REQUIRE(it1 == results1.end());
-    it1 = results1.find("hi");
-    REQUIRE(it1 != results1.end());
+    const PostingList<std::string> *results1 = copyTree.find("hola");
+    REQUIRE(results1->size() == 1);
+    REQUIRE(results1->getFrequency("hola") == 0);
+    REQUIRE(results1->getFrequency("hi") == 1);
 }
 
 // Test suite for the assignment operator of the DSAvlTree class
@@ -184,13 +176,94 @@ TEST_CASE("Assignment Operator", "[DSAvlTree]")
     copy = original; // Using the assignment operator
 
     // Check if elements from original are now in copy
-    REQUIRE(copy.contains("HELLO!").size() == 1);
-    REQUIRE(copy.contains("HI").size() == 1);
-    REQUIRE(copy.contains("hola").size() == 1);
+    REQUIRE(copy.contains("HELLO!") == true);
+    REQUIRE(copy.contains("HI") == true);
+    REQUIRE(copy.contains("hola") == true);
 
     copy.remove("HELLO!"); // Remove an element from the copy
 
     // Check if the removal in the copy does not affect the original
-    REQUIRE(original.contains("HELLO!").size() == 1);
-    REQUIRE(copy.contains("HELLO!").size() == 0);
+    REQUIRE(original.contains("HELLO!") == true);
+    REQUIRE(copy.contains("HELLO!") == false);
+}
+
+// Test suite for the 'finalize' function of the DSAvlTree class
+TEST_CASE("finalize", "[DSAvlTree]")
+{
+    // Values inserted out of order are sorted and combined once the tree is finalized
+    DSAvlTree<std::string, int> test1;
+    test1.insert("hola", 30);
+    test1.insert("hola", 10);
+    test1.insert("hola", 20, 4);
+    test1.insert("hola", 10);
+    REQUIRE(test1.find("hola")->getFrequency(10) == 2); // lookups work before finalizing too
+    test1.finalize();
+
+    const PostingList<int> *results = test1.find("hola");
+    REQUIRE(results->size() == 3);
+    REQUIRE(results->getId(0) == 10);
+    REQUIRE(results->getFreq(0) == 2);
+    REQUIRE(results->getId(1) == 20);
+    REQUIRE(results->getFreq(1) == 4);
+    REQUIRE(results->getId(2) == 30);
+    REQUIRE(results->getFreq(2) == 1);
+}
+
+// Test suite for the move constructor and move assignment of the DSAvlTree class
+TEST_CASE("Move", "[DSAvlTree]")
+{
+    DSAvlTree<std::string, int> original;
+    original.insert("HELLO!", 4);
+    original.insert("HI", 4);
+    const PostingList<int> *postings = original.find("HI");
+
+    // Moving hands the nodes over without copying them
+    DSAvlTree<std::string, int> moved(std::move(original));
+    REQUIRE(moved.find("HI") == postings);
+    REQUIRE(moved.getSize() == 2);
+    REQUIRE(original.getSize() == 0);
+    REQUIRE(original.contains("HI") == false);
+
+    DSAvlTree<std::string, int> assigned;
+    assigned.insert("bye", 10);
+    assigned = std::move(moved);
+    REQUIRE(assigned.find("HI") == postings);
+    REQUIRE(assigned.contains("bye") == false);
+    REQUIRE(moved.getSize() == 0);
+}
+
+// Test suite for the node allocation policies of the DSAvlTree class
+TEST_CASE("Allocation policy", "[DSAvlTree]")
+{
+    // The default pool: a copy owns its own nodes and outlives the tree it was copied from
+    DSAvlTree<int, int> *pooled = new DSAvlTree<int, int>;
+    for (int i = 0; i < 1000; i++)
+    {
+        pooled->insert(i, i % 7);
+    }
+    pooled->remove(500);
+    pooled->insert(500, 3); // reuses the slot of the removed node
+    DSAvlTree<int, int> copy(*pooled);
+    delete pooled;
+    REQUIRE(copy.getSize() == 1000);
+    REQUIRE(copy.find(500)->getId(0) == 3);
+    REQUIRE(copy.find(999)->getId(0) == 999 % 7);
+
+    // The pool can be refilled after makeEmpty gave its memory back
+    copy.makeEmpty();
+    copy.insert(1, 1);
+    REQUIRE(copy.getSize() == 1);
+    REQUIRE(copy.contains(1));
+
+    // One heap allocation per node behaves the same
+    DSAvlTree<int, int, HeapAllocator> heap;
+    for (int i = 0; i < 1000; i++)
+    {
+        heap.insert(i, i % 7);
+    }
+    heap.remove(500);
+    DSAvlTree<int, int, HeapAllocator> heapCopy = heap;
+    REQUIRE(heapCopy.getSize() == heap.getSize());
+    REQUIRE(heapCopy.contains(500) == false);
+    REQUIRE(heapCopy.find(999)->getId(0) == 999 % 7);
 }
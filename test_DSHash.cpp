@@ -11,13 +11,12 @@ TEST_CASE("clear", "[DSHash]")
     test1.insert("HI", "hi");
     test1.insert("hola", "hi");
     // Testing find function and checking the size of results
-    std::map<std::string, int> results = test1.find("hola");
+    const PostingList<std::string> *results = test1.find("hola");
     results = test1.find("HI");
     results = test1.find("HELLO!");
-    REQUIRE(results.size() == 1); // Confirming the size of the results
-    results.clear();              // Clear the results
-    test1.clear();                // Clear the hash map
-    REQUIRE(results.size() == 0); // Checking the results are now empty
+    REQUIRE(results->size() == 1);            // Confirming the size of the results
+    test1.clear();                            // Clear the hash map
+    REQUIRE(test1.find("HELLO!") == nullptr); // Checking the key is gone
 
     // Test with int-to-int hash map
     Hash<int, int> test2;
@@ -25,13 +24,13 @@ TEST_CASE("clear", "[DSHash]")
     test2.insert(50, 200);
     test2.insert(600, 200);
     // Testing find function and checking the size of results
-    std::map<int, int> results2 = test2.find(4);
+    const PostingList<int> *results2 = test2.find(4);
     results2 = test2.find(50);
     results2 = test2.find(600);
-    REQUIRE(results2.size() == 1); // Confirming the size of the results
-    results2.clear();              // Clear the results
-    test1.clear();                 // Clear the hash map (intended to be test2.clear()?)
-    REQUIRE(results.size() == 0);  // Checking the results are now empty
+    REQUIRE(results2->size() == 1);            // Confirming the size of the results
+    REQUIRE(results2->getFrequency(200) == 1); // Checking the value was stored once
+    test2.clear();                             // Clear the hash map
+    REQUIRE(test2.find(600) == nullptr);       // Checking the key is gone
 }
 
 // Test suite for the 'clone' function of the Hash class
@@ -132,3 +131,55 @@ TEST_CASE("get size", "[DSHash]")
     test2.clear();                 // Clearing the hash map
     REQUIRE(test2.getSize() == 0); // Checking the size is now 0
 }
+
+// Test case for moving a hash table
+TEST_CASE("move", "[DSHash]")
+{
+    Hash<std::string, int> test1;
+    test1.insert("hello", 1);
+    test1.insert("goodbye", 2);
+    const PostingList<int> *postings = test1.find("hello");
+
+    // Moving hands the buckets over without copying them; the source is left empty but usable
+    Hash<std::string, int> test2(std::move(test1));
+    REQUIRE(test2.find("hello") == postings);
+    REQUIRE(test2.getSize() == 2);
+    REQUIRE(test1.getSize() == 0);
+    REQUIRE(test1.find("hello") == nullptr);
+    test1.insert("again", 3);
+    REQUIRE(test1.getSize() == 1);
+
+    Hash<std::string, int> test3;
+    test3.insert("old", 4);
+    test3 = std::move(test2);
+    REQUIRE(test3.find("hello") == postings);
+    REQUIRE(test3.find("old") == nullptr);
+}
+
+// Test case for the node allocation policies of the hash table
+TEST_CASE("allocation policy", "[DSHash]")
+{
+    // The default pool keeps the nodes valid across rehashes, copies and clears
+    Hash<int, int> pooled;
+    for (int i = 0; i < 1000; i++)
+    {
+        pooled.insert(i, i % 7);
+    }
+    Hash<int, int> copy(pooled);
+    pooled.clear();
+    REQUIRE(pooled.getSize() == 0);
+    REQUIRE(copy.getSize() == 1000);
+    REQUIRE(copy.find(999)->getId(0) == 999 % 7);
+    pooled.insert(5, 5);
+    REQUIRE(pooled.find(5)->getId(0) == 5);
+
+    // One heap allocation per node behaves the same
+    Hash<int, int, HeapAllocator> heap;
+    for (int i = 0; i < 1000; i++)
+    {
+        heap.insert(i, i % 7);
+    }
+    Hash<int, int, HeapAllocator> heapCopy = heap;
+    REQUIRE(heapCopy.getSize() == 1000);
+    REQUIRE(heapCopy.find(999)->getId(0) == 999 % 7);
+}
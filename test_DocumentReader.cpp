@@ -0,0 +1,63 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "DocumentReader.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+// Writes json to a temporary file and returns its path
+static std::string writeTemp(const std::string &json)
+{
+    std::string path = "test_DocumentReader.json";
+    std::ofstream out(path, std::ios::binary);
+    out << json;
+    return path;
+}
+
+// Test case for extracting the kept fields
+TEST_CASE("fields", "[DocumentReader]")
+{
+    std::string path = writeTemp(R"({"uuid": "abc", "thread": {"title": "Nested", "site": "cnbc.com", "x": [1, {"site": "no"}]},
+        "title": "Markets \"rally\"", "text": "Stocks rose\nsharply", "published": "2018-02-06T10:00:00.000+02:00",
+        "ord_in_thread": 0, "highlightTitle": null, "crawled": true,
+        "entities": {"persons": [{"name": "jane doe", "sentiment": "none"}, {"name": "john"}],
+                     "organizations": [{"sentiment": "none", "name": "acme corp"}],
+                     "locations": [{"name": "paris"}]},
+        "persons": "", "organizations": "acme"})");
+    DocumentReader document;
+    REQUIRE(document.read(path));
+    REQUIRE(document.title == "Markets \"rally\"");
+    REQUIRE(document.text == "Stocks rose\nsharply");
+    REQUIRE(document.published.substr(0, 10) == "2018-02-06");
+    REQUIRE(document.site == "cnbc.com");
+    REQUIRE(document.personNames.size() == 2);
+    REQUIRE(document.personNames[0] == "jane doe");
+    REQUIRE(document.personNames[1] == "john");
+    REQUIRE(document.orgNames.size() == 1);
+    REQUIRE(document.orgNames[0] == "acme corp");
+    REQUIRE(document.hasPersons);
+    REQUIRE(document.persons.empty());
+    REQUIRE(document.orgs == "acme");
+
+    // A second document reuses the reader and keeps nothing from the first
+    path = writeTemp(R"({"title": "Only a title"})");
+    REQUIRE(document.read(path));
+    REQUIRE(document.title == "Only a title");
+    REQUIRE(document.hasTitle);
+    REQUIRE_FALSE(document.hasText);
+    REQUIRE_FALSE(document.hasSite);
+    REQUIRE(document.personNames.empty());
+    REQUIRE(document.orgNames.empty());
+    std::remove(path.c_str());
+}
+
+// Test case for files that cannot be read
+TEST_CASE("errors", "[DocumentReader]")
+{
+    DocumentReader document;
+    REQUIRE_FALSE(document.read("no_such_file.json"));
+
+    std::string path = writeTemp(R"({"title": "cut off)");
+    REQUIRE_FALSE(document.read(path));
+    std::remove(path.c_str());
+}
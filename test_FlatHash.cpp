@@ -0,0 +1,104 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "FlatHash.h"
+#include <map>
+#include <random>
+#include <string>
+
+// Test suite for the 'insert' and 'find' functions of the FlatHash class
+TEST_CASE("insert", "[FlatHash]")
+{
+    FlatHash<std::string, int> test1;
+    test1.insert("HELLO!", 1);
+    test1.insert("HI", 2);
+    test1.insert("HELLO!", 1);
+    test1.insert("HELLO!", 3, 4);
+    REQUIRE(test1.getSize() == 2);
+    REQUIRE(test1.find("HELLO!")->getFrequency(1) == 2);
+    REQUIRE(test1.find("HELLO!")->getFrequency(3) == 4);
+    REQUIRE(test1.find("HI")->size() == 1);
+    REQUIRE(test1.find("hola") == nullptr);
+
+    // Integer keys share their low bits between the tag and the group, which must still work
+    FlatHash<int, int> test2;
+    for (int i = 0; i < 1000; i++)
+    {
+        test2.insert(i * 128, i);
+    }
+    REQUIRE(test2.getSize() == 1000);
+    for (int i = 0; i < 1000; i++)
+    {
+        REQUIRE(test2.find(i * 128) != nullptr);
+        REQUIRE(test2.find(i * 128)->getId(0) == i);
+        REQUIRE(test2.find(i * 128 + 1) == nullptr);
+    }
+}
+
+// Test suite for the 'clear' function of the FlatHash class
+TEST_CASE("clear", "[FlatHash]")
+{
+    FlatHash<std::string, int> test1;
+    for (int i = 0; i < 100; i++)
+    {
+        test1.insert("key" + std::to_string(i), i);
+    }
+    REQUIRE(test1.getSize() == 100);
+    test1.clear();
+    REQUIRE(test1.getSize() == 0);
+    REQUIRE(test1.find("key5") == nullptr);
+    test1.insert("key5", 1);
+    REQUIRE(test1.find("key5")->getId(0) == 1);
+}
+
+// Test suite for copying, moving, merging and visiting FlatHash tables
+TEST_CASE("copy, merge and forEach", "[FlatHash]")
+{
+    FlatHash<std::string, int> test1;
+    test1.insert("a", 1);
+    test1.insert("b", 2);
+
+    FlatHash<std::string, int> copy = test1;
+    copy.insert("c", 3);
+    REQUIRE(copy.getSize() == 3);
+    REQUIRE(test1.getSize() == 2);
+    REQUIRE(test1.find("c") == nullptr);
+
+    FlatHash<std::string, int> moved = std::move(copy);
+    REQUIRE(moved.getSize() == 3);
+
+    test1.merge(moved, [](int v)
+                { return v + 10; });
+    REQUIRE(test1.getSize() == 3);
+    REQUIRE(test1.find("a")->size() == 2);
+    REQUIRE(test1.find("a")->getFrequency(11) == 1);
+    REQUIRE(test1.find("c")->getId(0) == 13);
+
+    int visited = 0;
+    test1.forEach([&visited](const std::string &, const PostingList<int> &postings)
+                  { visited += postings.size(); });
+    REQUIRE(visited == 5);
+}
+
+// Randomised comparison against std::map, across many rehashes
+TEST_CASE("matches std::map", "[FlatHash]")
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> keys(0, 20000);
+    FlatHash<std::string, int> table;
+    std::map<std::string, int> expected;
+    for (int i = 0; i < 50000; i++)
+    {
+        std::string key = "k" + std::to_string(keys(rng));
+        table.insert(key, i);
+        expected[key]++;
+    }
+    table.finalize();
+    REQUIRE(table.getSize() == (int)expected.size());
+    for (const auto &entry : expected)
+    {
+        const PostingList<int> *postings = table.find(entry.first);
+        REQUIRE(postings != nullptr);
+        REQUIRE((int)postings->size() == entry.second);
+    }
+    REQUIRE(table.find("missing") == nullptr);
+}
@@ -2,6 +2,10 @@
 #include "catch.hpp"
 #include "IndexHandler.h"
 #include "DocumentParser.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 using namespace std;
 
 // Test suite for IndexHandler
@@ -14,33 +18,67 @@ TEST_CASE("IndexHandler Test", "[IndexHandler]")
     dp.parseDocument("../sample_data/coll_1/news_0064567.json");
     IndexHandler ih = dp.getIndex(); // Getting the IndexHandler from DocumentParser
 
+    // Test case to verify the document table
+    SECTION("Document Table Test")
+    {
+        // The first parsed document gets ID 0, which maps back to its path and title
+        REQUIRE(ih.getDocSize() == 1);
+        REQUIRE(ih.getDocPath(0) == "../sample_data/coll_1/news_0064567.json");
+        REQUIRE(ih.getTitle(0) == "German firms doing business in UK gloomy about Brexit - survey");
+    }
+
+    // Test case to verify the metadata shown for results, in memory and after persistence
+    SECTION("Document Metadata Test")
+    {
+        IndexHandler table;
+        DocId id = table.addDocument("meta.json", "Meta title", "cnbc.com", "2018-02-06");
+        DocId bare = table.addDocument("bare.json", "Bare");
+        table.addWordCount(id, 3);
+        REQUIRE(table.getPublication(id) == "cnbc.com");
+        REQUIRE(table.getDate(id) == "2018-02-06");
+        REQUIRE(table.getPublication(bare).empty());
+
+        table.createPersistence();
+        IndexHandler mapped;
+        mapped.readPersistence();
+        REQUIRE(mapped.getDocSize() == 2);
+        REQUIRE(mapped.getDocPath(id) == "meta.json");
+        REQUIRE(mapped.getTitle(id) == "Meta title");
+        REQUIRE(mapped.getPublication(id) == "cnbc.com");
+        REQUIRE(mapped.getDate(id) == "2018-02-06");
+        REQUIRE(mapped.getWordCount(id) == 3);
+        REQUIRE(mapped.getDocPath(bare) == "bare.json");
+        REQUIRE(mapped.getTitle(bare) == "Bare");
+        REQUIRE(mapped.getDate(bare).empty());
+    }
+
     // Test case to verify getWords functionality
     SECTION("getWords Test")
     {
         // Tests to verify the correct mapping of words to their counts and document paths
         // Each REQUIRE checks that the function returns the expected number of occurrences and paths
         // Test cases for different words and their expected occurrences
-        map<string, int> result = ih.getWords("plan");
+        PostingView<DocId> result = ih.getWords("plan");
         REQUIRE(result.size() == 1);
-        REQUIRE(result["../sample_data/coll_1/news_0064567.json"] == 2);
+        REQUIRE(result.getFrequency(0) == 2);
 
-        map<string, int> result1 = ih.getWords("german");
+        PostingView<DocId> result1 = ih.getWords("german");
         REQUIRE(result1.size() == 1);
-        REQUIRE(result1["../sample_data/coll_1/news_0064567.json"] == 4);
+        REQUIRE(result1.getFrequency(0) == 4);
 
-        map<string, int> result2 = ih.getWords("interest");
+        PostingView<DocId> result2 = ih.getWords("interest");
         REQUIRE(result2.size() == 1);
-        REQUIRE(result2["../sample_data/coll_1/news_0064567.json"] == 1);
+        REQUIRE(result2.getFrequency(0) == 1);
 
-        map<string, int> result3 = ih.getWords("prospect");
+        PostingView<DocId> result3 = ih.getWords("prospect");
         REQUIRE(result3.size() == 1);
-        REQUIRE(result3["../sample_data/coll_1/news_0064567.json"] == 3);
+        REQUIRE(result3.getFrequency(0) == 3);
 
-        map<string, int> result5 = ih.getWords("potato");
-        REQUIRE(result5.size() == 0);
+        PostingView<DocId> result5 = ih.getWords("potato");
+        REQUIRE(result5.empty());
 
-        map<string, int> result6 = ih.getWords("orange");
-        REQUIRE(result6.size() == 0);
+        PostingView<DocId> result6 = ih.getWords("orange");
+        REQUIRE(result6.empty());
     }
 
     // Test case to verify getPeople functionality
@@ -50,14 +88,14 @@ TEST_CASE("IndexHandler Test", "[IndexHandler]")
         // Each REQUIRE checks that the function returns the expected number of occurrences and paths
 
         // Test cases for different names and their expected occurrences
-        map<string, int> result4 = ih.getPeople("schweitzer");
+        PostingView<DocId> result4 = ih.getPeople("schweitzer");
         REQUIRE(result4.size() == 1);
-        map<string, int> result5 = ih.getPeople("adam");
-        REQUIRE(result5.size() == 0);
-        map<string, int> result6 = ih.getPeople("george");
-        REQUIRE(result6.size() == 0);
-        map<string, int> result7 = ih.getPeople("sarah");
-        REQUIRE(result7.size() == 0);
+        PostingView<DocId> result5 = ih.getPeople("adam");
+        REQUIRE(result5.empty());
+        PostingView<DocId> result6 = ih.getPeople("george");
+        REQUIRE(result6.empty());
+        PostingView<DocId> result7 = ih.getPeople("sarah");
+        REQUIRE(result7.empty());
     }
     // Test case to verify getWordCount functionality
     SECTION("getWordCount Test")
@@ -66,7 +104,7 @@ TEST_CASE("IndexHandler Test", "[IndexHandler]")
         // REQUIRE checks that the function returns the expected word count for the document
 
         // Test case for a specific document and its expected word count
-        REQUIRE(ih.getWordCount("../sample_data/coll_1/news_0064567.json") == 251);
+        REQUIRE(ih.getWordCount(0) == 251);
     }
 
     // Test case to verify getOrgs functionality
@@ -76,15 +114,15 @@ TEST_CASE("IndexHandler Test", "[IndexHandler]")
         // Each REQUIRE checks that the function returns the expected number of occurrences and paths
 
         // Test cases for different organizations and their expected occurrences
-        map<string, int> result = ih.getOrgs("cnn");
-        REQUIRE(result.size() == 0);
-        map<string, int> result1 = ih.getOrgs("nbc");
-        REQUIRE(result1.size() == 0);
-        map<string, int> result2 = ih.getOrgs("abc");
-        REQUIRE(result2.size() == 0);
-        map<string, int> result3 = ih.getOrgs("reuters");
+        PostingView<DocId> result = ih.getOrgs("cnn");
+        REQUIRE(result.empty());
+        PostingView<DocId> result1 = ih.getOrgs("nbc");
+        REQUIRE(result1.empty());
+        PostingView<DocId> result2 = ih.getOrgs("abc");
+        REQUIRE(result2.empty());
+        PostingView<DocId> result3 = ih.getOrgs("reuters");
         REQUIRE(result3.size() == 1);
-        REQUIRE(result3["../sample_data/coll_1/news_0064567.json"] == 1);
+        REQUIRE(result3.getFrequency(0) == 1);
     }
 
     // Test case to verify persistence functionality
@@ -101,46 +139,135 @@ TEST_CASE("IndexHandler Test", "[IndexHandler]")
         // Tests to verify the data integrity after reading from persistence
         // Test cases to verify the correct data is retrieved after persistence
 
-        map<string, int> result = index.getWords("plan");
+        PostingView<DocId> result = index.getWords("plan");
         REQUIRE(result.size() == 1);
-        REQUIRE(result["../sample_data/coll_1/news_0064567.json"] == 2); // should be 2
-        REQUIRE(result["../sample_data/coll_1/news_0064567.json"] == 2);
-        map<string, int> result1 = index.getWords("german");
+        REQUIRE(result.getFrequency(0) == 2); // should be 2
+        REQUIRE(result.getFrequency(0) == 2);
+        PostingView<DocId> result1 = index.getWords("german");
         REQUIRE(result1.size() == 1);
-        REQUIRE(result1["../sample_data/coll_1/news_0064567.json"] == 4);
-        map<string, int> result2 = index.getWords("interest");
+        REQUIRE(result1.getFrequency(0) == 4);
+        PostingView<DocId> result2 = index.getWords("interest");
         REQUIRE(result2.size() == 1);
-        REQUIRE(result2["../sample_data/coll_1/news_0064567.json"] == 1);
-        map<string, int> result3 = index.getWords("prospect");
+        REQUIRE(result2.getFrequency(0) == 1);
+        PostingView<DocId> result3 = index.getWords("prospect");
         REQUIRE(result3.size() == 1);
-        REQUIRE(result3["../sample_data/coll_1/news_0064567.json"] == 3);
-        map<string, int> result5 = index.getWords("potato");
-        REQUIRE(result5.size() == 0);
-        map<string, int> result6 = index.getWords("orange");
-        REQUIRE(result6.size() == 0);
-        map<string, int> result10 = index.getPeople("schweitzer");
+        REQUIRE(result3.getFrequency(0) == 3);
+        PostingView<DocId> result5 = index.getWords("potato");
+        REQUIRE(result5.empty());
+        PostingView<DocId> result6 = index.getWords("orange");
+        REQUIRE(result6.empty());
+        PostingView<DocId> result10 = index.getPeople("schweitzer");
         REQUIRE(result10.size() == 1);
-        map<string, int> result11 = index.getPeople("adam");
-        REQUIRE(result11.size() == 0);
-        map<string, int> result12 = index.getPeople("george");
-        REQUIRE(result12.size() == 0);
-        map<string, int> result13 = index.getPeople("sarah");
-        REQUIRE(result13.size() == 0);
-
-        REQUIRE(index.getWordCount("../sample_data/coll_1/news_0064567.json") == 251);
-
-        map<string, int> result14 = index.getOrgs("cnn");
-        REQUIRE(result14.size() == 0);
-        map<string, int> result15 = index.getOrgs("nbc");
-        REQUIRE(result15.size() == 0);
-        map<string, int> result16 = index.getOrgs("abc");
-        REQUIRE(result16.size() == 0);
-        map<string, int> result17 = index.getOrgs("Reuters");
-        REQUIRE(result17.size() == 0);
+        PostingView<DocId> result11 = index.getPeople("adam");
+        REQUIRE(result11.empty());
+        PostingView<DocId> result12 = index.getPeople("george");
+        REQUIRE(result12.empty());
+        PostingView<DocId> result13 = index.getPeople("sarah");
+        REQUIRE(result13.empty());
+
+        REQUIRE(index.getWordCount(0) == 251);
+
+        PostingView<DocId> result14 = index.getOrgs("cnn");
+        REQUIRE(result14.empty());
+        PostingView<DocId> result15 = index.getOrgs("nbc");
+        REQUIRE(result15.empty());
+        PostingView<DocId> result16 = index.getOrgs("abc");
+        REQUIRE(result16.empty());
+        PostingView<DocId> result17 = index.getOrgs("Reuters");
+        REQUIRE(result17.empty());
 
         REQUIRE(index.getDocSize() == 1);
     }
 
+    // Test case to verify merging a partial index built by a worker thread
+    SECTION("Merge Test")
+    {
+        IndexHandler partial;
+        DocId id = partial.addDocument("partial.json", "Partial");
+        partial.addWords("plan", id);
+        partial.addPeople("schweitzer", id);
+        partial.addWordCount(id, 7);
+
+        ih.merge(partial); // The partial index's document 0 becomes document 1 here
+
+        REQUIRE(ih.getDocSize() == 2);
+        REQUIRE(ih.getDocPath(1) == "partial.json");
+        REQUIRE(ih.getWordCount(1) == 7);
+        PostingView<DocId> result = ih.getWords("plan");
+        REQUIRE(result.size() == 2);
+        REQUIRE(result.getFrequency(0) == 2);
+        REQUIRE(result.getFrequency(1) == 1);
+        REQUIRE(ih.getPeople("schweitzer").size() == 2);
+    }
+
+    // Test case to verify word positions through merging and persistence
+    SECTION("Positions Test")
+    {
+        IndexHandler table, partial;
+        REQUIRE(!table.hasPositions());
+        table.addPosition("plan", table.addDocument("a.json", "A"), 0); // Ignored without positions
+        REQUIRE(table.getPositions("plan").empty());
+
+        table = IndexHandler();
+        table.enablePositions();
+        partial.enablePositions();
+        DocId first = table.addDocument("a.json", "A");
+        table.addWords("plan", first);
+        table.addPosition("plan", first, 3);
+        DocId second = partial.addDocument("b.json", "B");
+        partial.addWords("plan", second);
+        partial.addPosition("plan", second, 1);
+        partial.addWords("plan", second);
+        partial.addPosition("plan", second, 4);
+        table.merge(partial);
+        table.finalize();
+
+        std::vector<uint32_t> positions;
+        REQUIRE(table.getPositions("plan").size() == 2);
+        table.getPositions("plan").get(1, positions);
+        REQUIRE(positions == std::vector<uint32_t>{1, 4});
+
+        table.createPersistence();
+        IndexHandler mapped;
+        mapped.readPersistence();
+        REQUIRE(mapped.hasPositions());
+        mapped.getPositions("plan").get(0, positions);
+        REQUIRE(positions == std::vector<uint32_t>{3});
+        REQUIRE(mapped.getPositions("potato").empty());
+    }
+
+    // Test case to verify that a damaged persistence file is refused instead of read out of bounds
+    SECTION("Corrupted Persistence Test")
+    {
+        IndexHandler table;
+        DocId id = table.addDocument("a.json", "A", "site", "2018-01-01");
+        table.addWords("plan", id);
+        table.addPeople("schweitzer", id);
+        table.addWordCount(id, 1);
+        table.finalize();
+        table.createPersistence();
+        REQUIRE(IndexFile::open("persistence.idx") != nullptr);
+
+        std::ifstream in("persistence.idx", std::ios::binary);
+        const std::string original((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        // The header starts with the magic, the version, the file size and the document count
+        auto rewrite = [](std::string bytes, size_t length, uint64_t docCount)
+        {
+            bytes.resize(length);
+            uint64_t fileSize = length;
+            std::memcpy(&bytes[8], &fileSize, sizeof(fileSize));
+            std::memcpy(&bytes[16], &docCount, sizeof(docCount));
+            std::ofstream("corrupted.idx", std::ios::binary | std::ios::trunc) << bytes;
+            return IndexFile::open("corrupted.idx");
+        };
+        REQUIRE(rewrite(original, original.size(), 1) != nullptr);
+        REQUIRE(rewrite(original, original.size() / 2, 1) == nullptr); // Sections past the end
+        REQUIRE(rewrite(original, original.size(), 1000) == nullptr);  // Document table past the end
+        REQUIRE(rewrite(original, original.size(), uint64_t(-1)) == nullptr);
+        std::remove("corrupted.idx");
+    }
+
     // Test case to verify functionality with multiple documents
     SECTION("Multiple Doc Testing")
     {
@@ -151,14 +278,14 @@ TEST_CASE("IndexHandler Test", "[IndexHandler]")
         // Tests to verify the correct handling of multiple documents
         // Test cases for words present in multiple documents
 
-        map<string, int> result1 = ih.getWords("german");
+        PostingView<DocId> result1 = ih.getWords("german");
         REQUIRE(result1.size() == 1);
-        REQUIRE(result1["../sample_data/coll_1/news_0064567.json"] == 4);
+        REQUIRE(result1.getFrequency(0) == 4);
 
-        map<string, int> result2 = ih.getWords("group");
+        PostingView<DocId> result2 = ih.getWords("group");
         REQUIRE(result2.size() == 2);
-        REQUIRE(result2["../sample_data/coll_1/news_0064567.json"] == 1);
-        REQUIRE(result2["../sample_data/coll_1/news_0064568.json"] == 2);
+        REQUIRE(result2.getFrequency(0) == 1);
+        REQUIRE(result2.getFrequency(1) == 2);
 
         ih.createPersistence();
 
@@ -166,13 +293,13 @@ TEST_CASE("IndexHandler Test", "[IndexHandler]")
 
         index2.readPersistence();
 
-        map<string, int> result = ih.getWords("german");
+        PostingView<DocId> result = ih.getWords("german");
         REQUIRE(result.size() == 1);
-        REQUIRE(result["../sample_data/coll_1/news_0064567.json"] == 4);
+        REQUIRE(result.getFrequency(0) == 4);
 
-        map<string, int> result3 = ih.getWords("group");
+        PostingView<DocId> result3 = ih.getWords("group");
         REQUIRE(result3.size() == 2);
-        REQUIRE(result3["../sample_data/coll_1/news_0064567.json"] == 1);
-        REQUIRE(result3["../sample_data/coll_1/news_0064568.json"] == 2);
+        REQUIRE(result3.getFrequency(0) == 1);
+        REQUIRE(result3.getFrequency(1) == 2);
     }
 }
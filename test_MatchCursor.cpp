@@ -0,0 +1,322 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "MatchCursor.h"
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+// Random ascending, duplicate-free document IDs below limit, each kept with the given probability, and random
+// frequencies that are mostly 1
+static void randomList(std::mt19937 &rng, DocId limit, double probability, std::vector<DocId> &ids, std::vector<int> &freqs)
+{
+    std::bernoulli_distribution keep(probability);
+    std::geometric_distribution<int> extra(0.6);
+    ids.clear();
+    freqs.clear();
+    for (DocId id = 0; id < limit; id++)
+    {
+        if (keep(rng))
+        {
+            ids.push_back(id);
+            freqs.push_back(1 + extra(rng));
+        }
+    }
+}
+
+// A finalized (compressed) posting list with the given entries
+static PostingList<DocId> compressedList(const std::vector<DocId> &ids, const std::vector<int> &freqs)
+{
+    PostingList<DocId> list;
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        list.add(ids[i], freqs[i]);
+    }
+    list.finalize();
+    return list;
+}
+
+// Walks a cursor to the end, recording each document with its score and frequency
+static void drain(MatchCursor &cursor, std::vector<DocId> &found, std::vector<double> &scores, std::vector<int> &freqs)
+{
+    for (; !cursor.atEnd(); cursor.next())
+    {
+        found.push_back(cursor.value());
+        scores.push_back(cursor.score());
+        freqs.push_back(cursor.freq());
+    }
+}
+
+// Test case for AND, OR and nested expressions against set operations on the lists
+TEST_CASE("expressions", "[MatchCursor]")
+{
+    const DocId limit = 20000;
+    std::mt19937 rng(3);
+    std::vector<int> lengths(limit);
+    std::uniform_int_distribution<int> length(1, 300);
+    for (int &l : lengths)
+    {
+        l = length(rng);
+    }
+    TfIdfScorer scorer;
+    scorer.setCorpus(lengths.data(), limit, 150, nullptr);
+
+    // Lists from dense to very sparse
+    const double densities[] = {0.4, 0.05, 0.01, 0.0005};
+    std::vector<std::vector<DocId>> ids(4);
+    std::vector<std::vector<int>> freqs(4);
+    std::vector<PostingList<DocId>> lists;
+    for (size_t t = 0; t < 4; t++)
+    {
+        randomList(rng, limit, densities[t], ids[t], freqs[t]);
+        lists.push_back(compressedList(ids[t], freqs[t]));
+    }
+    auto term = [&](size_t t)
+    { return std::make_unique<TermMatch>(lists[t].view(), scorer); };
+
+    // Score and frequency a set of terms give a document
+    auto expectedScore = [&](DocId id, std::initializer_list<size_t> terms)
+    {
+        double score = 0;
+        int freq = 0;
+        for (size_t t : terms)
+        {
+            auto itr = std::lower_bound(ids[t].begin(), ids[t].end(), id);
+            if (itr != ids[t].end() && *itr == id)
+            {
+                scorer.setTerm(ids[t].size());
+                score += scorer.score(id, freqs[t][itr - ids[t].begin()]);
+                freq += freqs[t][itr - ids[t].begin()];
+            }
+        }
+        return std::make_pair(score, freq);
+    };
+    auto check = [&](MatchCursor &cursor, const std::vector<DocId> &expected, std::initializer_list<size_t> terms)
+    {
+        std::vector<DocId> found;
+        std::vector<double> scores;
+        std::vector<int> foundFreqs;
+        drain(cursor, found, scores, foundFreqs);
+        REQUIRE(found == expected);
+        for (size_t i = 0; i < found.size(); i++)
+        {
+            auto score = expectedScore(found[i], terms);
+            REQUIRE(scores[i] == Approx(score.first));
+            REQUIRE(foundFreqs[i] == score.second);
+        }
+    };
+
+    SECTION("OR is the union")
+    {
+        std::vector<DocId> expected;
+        std::set_union(ids[1].begin(), ids[1].end(), ids[2].begin(), ids[2].end(), std::back_inserter(expected));
+        std::vector<DocId> all;
+        std::set_union(expected.begin(), expected.end(), ids[3].begin(), ids[3].end(), std::back_inserter(all));
+        std::vector<std::unique_ptr<MatchCursor>> operands;
+        operands.push_back(term(1));
+        operands.push_back(term(2));
+        operands.push_back(term(3));
+        OrMatch cursor(std::move(operands));
+        REQUIRE(cursor.cost() == ids[1].size() + ids[2].size() + ids[3].size());
+        check(cursor, all, {1, 2, 3});
+    }
+
+    SECTION("AND of an OR and a term, minus a term")
+    {
+        // (1 OR 2) 0 -3
+        std::vector<DocId> either, both, expected;
+        std::set_union(ids[1].begin(), ids[1].end(), ids[2].begin(), ids[2].end(), std::back_inserter(either));
+        std::set_intersection(either.begin(), either.end(), ids[0].begin(), ids[0].end(), std::back_inserter(both));
+        std::set_difference(both.begin(), both.end(), ids[3].begin(), ids[3].end(), std::back_inserter(expected));
+        std::vector<std::unique_ptr<MatchCursor>> alternatives, operands, excluded;
+        alternatives.push_back(term(1));
+        alternatives.push_back(term(2));
+        operands.push_back(std::make_unique<OrMatch>(std::move(alternatives)));
+        operands.push_back(term(0));
+        excluded.push_back(term(3));
+        AndMatch cursor(std::move(operands), std::move(excluded));
+        check(cursor, expected, {0, 1, 2});
+    }
+
+    SECTION("OR of ANDs, advanced")
+    {
+        // (0 1) OR (0 2) OR 3, advanced in strides
+        std::vector<DocId> a, b, ab, expected;
+        std::set_intersection(ids[0].begin(), ids[0].end(), ids[1].begin(), ids[1].end(), std::back_inserter(a));
+        std::set_intersection(ids[0].begin(), ids[0].end(), ids[2].begin(), ids[2].end(), std::back_inserter(b));
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(ab));
+        std::set_union(ab.begin(), ab.end(), ids[3].begin(), ids[3].end(), std::back_inserter(expected));
+        std::vector<std::unique_ptr<MatchCursor>> first, second, alternatives;
+        first.push_back(term(0));
+        first.push_back(term(1));
+        second.push_back(term(0));
+        second.push_back(term(2));
+        alternatives.push_back(std::make_unique<AndMatch>(std::move(first), std::vector<std::unique_ptr<MatchCursor>>()));
+        alternatives.push_back(std::make_unique<AndMatch>(std::move(second), std::vector<std::unique_ptr<MatchCursor>>()));
+        alternatives.push_back(term(3));
+        OrMatch cursor(std::move(alternatives));
+        for (DocId target = 0; target < limit; target += 97)
+        {
+            cursor.advance(target);
+            auto itr = std::lower_bound(expected.begin(), expected.end(), target);
+            if (itr == expected.end())
+            {
+                REQUIRE(cursor.atEnd());
+                break;
+            }
+            REQUIRE(cursor.value() == *itr);
+        }
+    }
+
+    SECTION("Empty operands")
+    {
+        // An AND of nothing matches nothing, an empty list ends an AND and is skipped by an OR
+        AndMatch nothing({}, {});
+        REQUIRE(nothing.atEnd());
+        PostingList<DocId> empty;
+        std::vector<std::unique_ptr<MatchCursor>> operands, alternatives;
+        operands.push_back(std::make_unique<TermMatch>(empty.view(), scorer));
+        operands.push_back(term(0));
+        REQUIRE(AndMatch(std::move(operands), {}).atEnd());
+        alternatives.push_back(std::make_unique<TermMatch>(empty.view(), scorer));
+        alternatives.push_back(term(3));
+        OrMatch cursor(std::move(alternatives));
+        check(cursor, ids[3], {3});
+    }
+}
+
+// Test case for phrases against a scan of every document's tokens
+TEST_CASE("phrases", "[MatchCursor]")
+{
+    // Documents of a few words, so that phrases occur often and words often occur without them
+    const DocId limit = 3000;
+    const size_t vocabulary = 5;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> length(1, 80), word(0, vocabulary - 1);
+    std::vector<std::vector<int>> texts(limit);
+    std::vector<int> lengths(limit);
+    std::vector<PostingList<DocId>> lists(vocabulary);
+    std::vector<PositionList> positions(vocabulary);
+    for (DocId id = 0; id < limit; id++)
+    {
+        texts[id].resize(id % 7 == 0 ? 0 : length(rng)); // Some documents are empty
+        lengths[id] = texts[id].size();
+        for (uint32_t position = 0; position < texts[id].size(); position++)
+        {
+            int w = texts[id][position] = word(rng);
+            lists[w].add(id, 1);
+            positions[w].add(id, position);
+        }
+    }
+    for (size_t w = 0; w < vocabulary; w++)
+    {
+        lists[w].finalize();
+        positions[w].finalize();
+    }
+    TfIdfScorer scorer;
+    scorer.setCorpus(lengths.data(), limit, 40, nullptr);
+
+    // Number of positions at which the words end a phrase match in a document, found by trying every chain
+    auto occurrences = [&](DocId id, const std::vector<int> &words, const std::vector<uint32_t> &offsets, uint32_t slop)
+    {
+        const std::vector<int> &text = texts[id];
+        std::vector<bool> ends(text.size(), false);
+        auto extend = [&](auto &self, size_t t, size_t previous) -> void
+        {
+            if (t == words.size())
+            {
+                ends[previous] = true;
+                return;
+            }
+            size_t low = previous + offsets[t] - offsets[t - 1];
+            for (size_t p = low; p <= low + slop && p < text.size(); p++)
+            {
+                if (text[p] == words[t])
+                {
+                    self(self, t + 1, p);
+                }
+            }
+        };
+        for (size_t p = 0; p < text.size(); p++)
+        {
+            if (text[p] == words[0])
+            {
+                extend(extend, 1, p);
+            }
+        }
+        return int(std::count(ends.begin(), ends.end(), true));
+    };
+
+    auto check = [&](const std::vector<int> &words, const std::vector<uint32_t> &offsets, uint32_t slop)
+    {
+        std::vector<PhraseMatch::Word> phrase;
+        for (size_t t = 0; t < words.size(); t++)
+        {
+            phrase.push_back(PhraseMatch::Word{lists[words[t]].view(), positions[words[t]].view(), offsets[t]});
+        }
+        PhraseMatch cursor(phrase, slop, scorer);
+        size_t matches = 0;
+        for (DocId id = 0; id < limit; id++)
+        {
+            int expected = occurrences(id, words, offsets, slop);
+            if (expected == 0)
+            {
+                continue;
+            }
+            REQUIRE(!cursor.atEnd());
+            REQUIRE(cursor.value() == id);
+            REQUIRE(cursor.freq() == expected);
+            double score = 0;
+            for (int w : words)
+            {
+                scorer.setTerm(lists[w].size());
+                score += scorer.score(id, lists[w].view().getFrequency(id));
+            }
+            REQUIRE(cursor.score() == Approx(score));
+            cursor.next();
+            matches++;
+        }
+        REQUIRE(cursor.atEnd());
+        REQUIRE(matches > 0);
+    };
+
+    SECTION("Adjacent words")
+    {
+        check({0, 1}, {0, 1}, 0);
+        check({2, 2, 2}, {0, 1, 2}, 0); // The same word more than once
+    }
+
+    SECTION("Gaps and slop")
+    {
+        check({3, 0, 4}, {0, 2, 3}, 0); // As if a stopword stood between the first two words
+        check({1, 4, 0}, {0, 1, 2}, 2);
+        check({0, 3}, {1, 2}, 5);
+    }
+
+    SECTION("Advanced")
+    {
+        std::vector<PhraseMatch::Word> phrase = {{lists[0].view(), positions[0].view(), 0}, {lists[1].view(), positions[1].view(), 1}};
+        PhraseMatch cursor(phrase, 0, scorer);
+        for (DocId target = 0; target < limit; target += 31)
+        {
+            cursor.advance(target);
+            DocId expected = target;
+            while (expected < limit && occurrences(expected, {0, 1}, {0, 1}, 0) == 0)
+            {
+                expected++;
+            }
+            if (expected == limit)
+            {
+                REQUIRE(cursor.atEnd());
+                break;
+            }
+            REQUIRE(cursor.value() == expected);
+        }
+    }
+
+    SECTION("Without positions")
+    {
+        std::vector<PhraseMatch::Word> phrase = {{lists[0].view(), PositionView(), 0}, {lists[1].view(), positions[1].view(), 1}};
+        REQUIRE(PhraseMatch(phrase, 0, scorer).atEnd());
+    }
+}
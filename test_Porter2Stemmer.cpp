@@ -0,0 +1,129 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "porter2_stemmer.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static const std::vector<std::string> ROOTS = {
+    "run", "hop", "happy", "nation", "relate", "condition", "rational", "generous", "good", "hope", "market", "econom",
+    "cry", "tie", "gas", "gap", "kiwi", "luxuri", "agree", "feed", "proceed", "sky", "fly", "say", "play", "employ",
+    "commun", "gener", "arsen", "univers", "fish", "wish", "analog", "geolog", "formal", "sensit", "digit", "effect",
+    "depend", "adjust", "adopt", "irrit", "bomb", "control", "roll", "fill", "call", "care", "hope", "use", "argu",
+    "trouble", "size", "fizz", "plan", "bat", "dull", "ebb", "add", "off", "egg", "dim", "inn", "tap", "err", "putt"};
+
+static const std::vector<std::string> SUFFIXES = {
+    "", "s", "es", "ies", "ied", "sses", "us", "ss", "ed", "edly", "eed", "eedly", "ing", "ingly", "y", "ly", "li",
+    "ational", "tional", "enci", "anci", "abli", "entli", "izer", "ization", "ation", "ator", "alism", "aliti",
+    "alli", "fulness", "ousli", "ousness", "iveness", "iviti", "biliti", "bli", "fulli", "lessli", "logi", "ogi",
+    "alize", "icate", "iciti", "ical", "ful", "ness", "ative", "al", "ance", "ence", "er", "ic", "able", "ible",
+    "ant", "ement", "ment", "ent", "ism", "ate", "iti", "ous", "ive", "ize", "ion", "sion", "tion", "e", "le", "ll",
+    "'s", "'s'", "'", "at", "bl", "iz", "eli", "yed", "ying"};
+
+static std::string referenceStem(std::string word)
+{
+    Porter2Stemmer::stem(word);
+    return word;
+}
+
+static std::string inPlaceStem(const std::string &word)
+{
+    char buffer[64];
+    word.copy(buffer, word.size());
+    return std::string(buffer, Porter2Stemmer::stem(buffer, word.size()));
+}
+
+// Test case for known stems
+TEST_CASE("stems", "[Porter2Stemmer]")
+{
+    REQUIRE(inPlaceStem("running") == "run");
+    REQUIRE(inPlaceStem("generously") == "generous");
+    REQUIRE(inPlaceStem("happiness") == "happi");
+    REQUIRE(inPlaceStem("relational") == "relat");
+    REQUIRE(inPlaceStem("hopping") == "hop");
+    REQUIRE(inPlaceStem("luxuriated") == "luxuri");
+    REQUIRE(inPlaceStem("skies") == "sky");
+    REQUIRE(inPlaceStem("news") == "news");
+    REQUIRE(inPlaceStem("an") == "an");
+    REQUIRE(inPlaceStem("<s>") == "<s>");
+    REQUIRE(inPlaceStem("'market's") == "market");
+    REQUIRE(inPlaceStem(std::string(40, 'a')) == std::string(35, 'a'));
+}
+
+// Test case comparing the in-place stemmer with the string stemmer
+TEST_CASE("same stems as the string stemmer", "[Porter2Stemmer]")
+{
+    // Every root with every suffix, and with two suffixes
+    for (const std::string &root : ROOTS)
+    {
+        for (const std::string &first : SUFFIXES)
+        {
+            std::string word = root + first;
+            REQUIRE(inPlaceStem(word) == referenceStem(word));
+            REQUIRE(inPlaceStem("'" + word) == referenceStem("'" + word));
+            for (const std::string &second : SUFFIXES)
+            {
+                std::string longer = word + second;
+                REQUIRE(inPlaceStem(longer) == referenceStem(longer));
+            }
+        }
+    }
+
+    // Random words over a vowel-heavy alphabet, up to past the 35-character cap
+    const std::string alphabet = "aeiouyyybcdlmnrstgziation";
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> letter(0, alphabet.size() - 1), length(3, 40);
+    for (int i = 0; i < 200000; i++)
+    {
+        std::string word;
+        for (size_t n = length(rng); word.size() < n;)
+        {
+            word += alphabet[letter(rng)];
+        }
+        REQUIRE(inPlaceStem(word) == referenceStem(word));
+    }
+}
+
+// Throughput of both stemmers on the same words. Hidden by default; run with: ./test_Porter2Stemmer [benchmark]
+TEST_CASE("throughput", "[.benchmark]")
+{
+    std::vector<std::string> words;
+    for (const std::string &root : ROOTS)
+    {
+        for (const std::string &suffix : SUFFIXES)
+        {
+            words.push_back(root + suffix);
+        }
+    }
+    const int rounds = 50;
+    auto wordsPerSecond = [&words](auto &&stemOne)
+    {
+        size_t total = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++)
+        {
+            for (const std::string &word : words)
+            {
+                total += stemOne(word);
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        REQUIRE(total > 0);
+        return rounds * words.size() / elapsed.count();
+    };
+    std::string scratch;
+    double strings = wordsPerSecond([&scratch](const std::string &word)
+                                    {
+                                        scratch = word;
+                                        Porter2Stemmer::stem(scratch);
+                                        return scratch.size(); });
+    char buffer[64];
+    double inPlace = wordsPerSecond([&buffer](const std::string &word)
+                                    {
+                                        word.copy(buffer, word.size());
+                                        return Porter2Stemmer::stem(buffer, word.size()); });
+    std::cout << "String stemmer: " << strings / 1e6 << "M words/s, in-place stemmer: " << inPlace / 1e6
+              << "M words/s" << std::endl;
+}
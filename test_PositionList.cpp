@@ -0,0 +1,129 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "PositionList.h"
+#include <random>
+#include <vector>
+
+// Random ascending positions for each of count documents, with gaps that now and then take several varint bytes
+static std::vector<std::vector<uint32_t>> randomRuns(std::mt19937 &rng, size_t count)
+{
+    std::uniform_int_distribution<int> length(1, 12);
+    std::geometric_distribution<uint32_t> gap(0.2);
+    std::bernoulli_distribution far(0.02);
+    std::vector<std::vector<uint32_t>> runs(count);
+    for (auto &run : runs)
+    {
+        uint32_t position = far(rng) ? 1u << 30 : 0;
+        for (int k = length(rng); k > 0; k--)
+        {
+            run.push_back(position);
+            position += 1 + gap(rng) + (far(rng) ? 1u << 20 : 0);
+        }
+    }
+    return runs;
+}
+
+// Test case for encoding and looking up position lists
+TEST_CASE("position lists", "[PositionList]")
+{
+    std::mt19937 rng(5);
+    std::vector<uint32_t> out;
+
+    SECTION("Varints")
+    {
+        std::vector<uint8_t> bytes;
+        const uint32_t values[] = {0, 1, 127, 128, 16383, 16384, 1u << 28, 0xffffffffu};
+        for (uint32_t v : values)
+        {
+            PositionCodec::appendVarint(bytes, v);
+        }
+        REQUIRE(bytes.size() == 1 + 1 + 1 + 2 + 2 + 3 + 5 + 5);
+        const uint8_t *p = bytes.data();
+        for (uint32_t v : values)
+        {
+            REQUIRE(PositionCodec::readVarint(p) == v);
+        }
+        REQUIRE(p == bytes.data() + bytes.size());
+    }
+
+    SECTION("Lookup across blocks")
+    {
+        // Several blocks and a partial last one, looked up out of order
+        const size_t count = 3 * BlockCodec::BLOCK_SIZE + 17;
+        auto runs = randomRuns(rng, count);
+        PositionList list;
+        for (size_t i = 0; i < count; i++)
+        {
+            for (uint32_t position : runs[i])
+            {
+                list.add(DocId(2 * i), position);
+            }
+        }
+        REQUIRE(list.size() == count);
+        REQUIRE(list.view().empty()); // Nothing to look at before finalize()
+        std::vector<uint8_t> unfinalized;
+        list.encode(unfinalized);
+
+        list.finalize();
+        PositionView view = list.view();
+        REQUIRE(view.size() == count);
+        REQUIRE(std::vector<uint8_t>(view.packedData(), view.packedData() + view.packedBytes()) == unfinalized);
+        for (size_t i = count; i-- > 0;)
+        {
+            view.get(i, out);
+            REQUIRE(out == runs[i]);
+        }
+    }
+
+    SECTION("Append")
+    {
+        // A partial list appended the way IndexHandler::merge appends a worker's index
+        auto runs = randomRuns(rng, 300);
+        PositionList first, second;
+        for (size_t i = 0; i < 300; i++)
+        {
+            for (uint32_t position : runs[i])
+            {
+                (i < 200 ? first : second).add(DocId(i < 200 ? i : i - 200), position);
+            }
+        }
+        first.append(second, 200);
+        first.append(PositionList(), 300);
+        runs[299].push_back(runs[299].back() + 1);
+        first.add(299, runs[299].back()); // Document 299 is still the last one, so its run goes on
+        first.finalize();
+        REQUIRE(first.size() == 300);
+        for (size_t i = 0; i < 300; i++)
+        {
+            first.view().get(i, out);
+            REQUIRE(out == runs[i]);
+        }
+    }
+
+    SECTION("Added to after finalize")
+    {
+        // A finalized list is decoded again when it is added to, and a finalized list can be appended
+        auto runs = randomRuns(rng, 300);
+        PositionList first, second;
+        for (size_t i = 0; i < 300; i++)
+        {
+            if (i == 100)
+            {
+                first.finalize();
+            }
+            for (uint32_t position : runs[i])
+            {
+                (i < 150 ? first : second).add(DocId(i < 150 ? i : i - 150), position);
+            }
+        }
+        second.finalize();
+        first.append(second, 150);
+        first.finalize();
+        REQUIRE(first.size() == 300);
+        for (size_t i = 0; i < 300; i++)
+        {
+            first.view().get(i, out);
+            REQUIRE(out == runs[i]);
+        }
+    }
+}
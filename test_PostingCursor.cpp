@@ -0,0 +1,156 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "PostingCursor.h"
+#include <random>
+#include <vector>
+
+// Random ascending, duplicate-free document IDs below limit, each kept with the given probability, and random
+// frequencies that are mostly 1
+static void randomList(std::mt19937 &rng, DocId limit, double probability, std::vector<DocId> &ids, std::vector<int> &freqs)
+{
+    std::bernoulli_distribution keep(probability);
+    std::geometric_distribution<int> extra(0.6);
+    ids.clear();
+    freqs.clear();
+    for (DocId id = 0; id < limit; id++)
+    {
+        if (keep(rng))
+        {
+            ids.push_back(id);
+            freqs.push_back(1 + extra(rng));
+        }
+    }
+}
+
+// A finalized (compressed) posting list with the given entries
+static PostingList<DocId> compressedList(const std::vector<DocId> &ids, const std::vector<int> &freqs)
+{
+    PostingList<DocId> list;
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        list.add(ids[i], freqs[i]);
+    }
+    list.finalize();
+    return list;
+}
+
+// Intersects two lists by leapfrogging their cursors, the way AndMatch joins the operands of a group
+static void leapfrog(const PostingView<DocId> &a, const PostingView<DocId> &b, std::vector<DocId> &found, std::vector<int> &freqs)
+{
+    PostingCursor<DocId> x(a), y(b);
+    while (!x.atEnd())
+    {
+        y.advance(x.value());
+        if (y.atEnd())
+        {
+            break;
+        }
+        if (y.value() == x.value())
+        {
+            found.push_back(x.value());
+            freqs.push_back(y.freq());
+            x.next();
+        }
+        else
+        {
+            x.advance(y.value());
+        }
+    }
+}
+
+// Test case for walking a list entry by entry
+TEST_CASE("next", "[PostingCursor]")
+{
+    std::mt19937 rng(11);
+    std::vector<DocId> ids;
+    std::vector<int> freqs;
+    for (DocId limit : {0u, 1u, 128u, 129u, 5000u})
+    {
+        randomList(rng, limit, 0.5, ids, freqs);
+        PostingList<DocId> compressed = compressedList(ids, freqs);
+        PostingView<DocId> plain(ids.data(), freqs.data(), ids.size());
+        for (const PostingView<DocId> &view : {plain, compressed.view()})
+        {
+            PostingCursor<DocId> cursor(view);
+            REQUIRE(cursor.size() == ids.size());
+            for (size_t i = 0; i < ids.size(); i++)
+            {
+                REQUIRE_FALSE(cursor.atEnd());
+                REQUIRE(cursor.value() == ids[i]);
+                REQUIRE(cursor.freq() == freqs[i]);
+                cursor.next();
+            }
+            REQUIRE(cursor.atEnd());
+        }
+    }
+}
+
+// Test case for advance() against std::lower_bound, with short and long jumps on plain and compressed lists
+TEST_CASE("advance", "[PostingCursor]")
+{
+    std::mt19937 rng(5);
+    std::vector<DocId> ids;
+    std::vector<int> freqs;
+    randomList(rng, 100000, 0.3, ids, freqs);
+    PostingList<DocId> compressed = compressedList(ids, freqs);
+    PostingView<DocId> plain(ids.data(), freqs.data(), ids.size());
+    for (DocId maxStep : {3u, 200u, 20000u})
+    {
+        for (const PostingView<DocId> &view : {plain, compressed.view()})
+        {
+            std::uniform_int_distribution<DocId> step(0, maxStep);
+            PostingCursor<DocId> cursor(view);
+            DocId target = 0;
+            while (!cursor.atEnd())
+            {
+                target += step(rng);
+                cursor.advance(target);
+                size_t expected = std::lower_bound(ids.begin(), ids.end(), target) - ids.begin();
+                if (expected == ids.size())
+                {
+                    REQUIRE(cursor.atEnd());
+                    break;
+                }
+                REQUIRE(cursor.value() == ids[expected]);
+                REQUIRE(cursor.freq() == freqs[expected]);
+            }
+        }
+    }
+
+    // advance() never moves backwards, and past the last ID the cursor ends
+    PostingCursor<DocId> cursor(compressed.view());
+    cursor.advance(ids[500]);
+    cursor.advance(ids[10]);
+    REQUIRE(cursor.value() == ids[500]);
+    cursor.advance(ids.back() + 1);
+    REQUIRE(cursor.atEnd());
+}
+
+// Test case for leapfrogging cursors over compressed lists against std::set_intersection
+TEST_CASE("intersection", "[PostingCursor]")
+{
+    std::mt19937 rng(3);
+    std::vector<DocId> a, b;
+    std::vector<int> aFreqs, bFreqs;
+    const double densities[] = {0.0005, 0.01, 0.3, 0.9};
+    for (double left : densities)
+    {
+        for (double right : densities)
+        {
+            randomList(rng, 30000, left, a, aFreqs);
+            randomList(rng, 30000, right, b, bFreqs);
+            PostingList<DocId> aList = compressedList(a, aFreqs), bList = compressedList(b, bFreqs);
+            std::vector<DocId> expected;
+            std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+
+            std::vector<DocId> found;
+            std::vector<int> freqs;
+            leapfrog(aList.view(), bList.view(), found, freqs);
+            REQUIRE(found == expected);
+            for (size_t i = 0; i < found.size(); i++)
+            {
+                REQUIRE(freqs[i] == bFreqs[std::lower_bound(b.begin(), b.end(), found[i]) - b.begin()]);
+            }
+        }
+    }
+}
@@ -7,13 +7,16 @@
 #include "IndexHandler.h"    // Include IndexHandler header for testing
 #include "DocumentParser.h"  // Include DocumentParser header for testing
 #include "porter2_stemmer.h" // Include Porter2 Stemmer header for testing
+#include "QueryServer.h"     // Include QueryServer header for testing
+#include <random>            // Standard library for generating test posting lists
+#include <cstdio>            // Standard library for removing test files
+#include <fstream>           // Standard library for writing test files
 
 // Test case for the query processor functionality
 TEST_CASE("query processor", "[QueryProcessor.h]")
 {
     // Create instances of DocumentParser, IndexHandler, and QueryProcessor for the test
     DocumentParser dp;
-    IndexHandler ih;
     QueryProcessor qp;
 
     // Parse sample documents using DocumentParser
@@ -23,26 +26,514 @@ TEST_CASE("query processor", "[QueryProcessor.h]")
     dp.parseDocument("../sample_data/coll_2/news_0064571.json");
 
     // Retrieve the index from DocumentParser and perform persistence operations
-    ih = dp.getIndex();     // Get the index from the DocumentParser
-    ih.createPersistence(); // Create a persistent representation of the index
-    ih.readPersistence();   // Read the index from persistence
-    ih = dp.getIndex();     // Update the IndexHandler with the latest index
+    std::shared_ptr<const IndexHandler> ih = dp.releaseIndex(); // Take the index over from the DocumentParser
+    ih->createPersistence();                                     // Create a persistent representation of the index
+    ih = IndexHandler::openPersistence();                        // Read the index from persistence
 
     // Set the IndexHandler in QueryProcessor
     qp.setIndexHandler(ih);
 
     // Test 1: Query processing for a specific query string
-    std::map<std::string, int> relevantDocs = qp.parsingAnswer("common PERSON:schweitzer");
+    PostingView<DocId> relevantDocs = qp.parsingAnswer("common PERSON:schweitzer");
     REQUIRE(relevantDocs.size() == 1); // Check if the result size is as expected
-    relevantDocs.clear();
 
     // Test 2: Query processing for another query string
     relevantDocs = qp.parsingAnswer("PERIOD PERSON:strax PERSON:ab");
     REQUIRE(relevantDocs.size() == 1); // Check if the result size is as expected
-    relevantDocs.clear();
 
-    // Test 3: Query processing for a different query string
+    // Test 3: Every term must match, and "ORGS:" is not a prefix, so "orgscarrefour" is looked up as a word
     relevantDocs = qp.parsingAnswer("stocks ORGS:carrefour PERSON:jerome powell");
-    REQUIRE(relevantDocs.size() == 1); // Check if the result size is as expected
-    relevantDocs.clear();
+    REQUIRE(relevantDocs.empty());
+
+    // Test 4: The result does not depend on the order of the terms
+    relevantDocs = qp.parsingAnswer("PERSON:schweitzer common");
+    REQUIRE(relevantDocs.size() == 1);
+}
+
+// Test case for ranking: the top k documents by tf-idf, best first
+TEST_CASE("ranking", "[QueryProcessor.h]")
+{
+    // Build a small index by hand: "market" occurs in three of four documents with different densities
+    std::shared_ptr<IndexHandler> ih = std::make_shared<IndexHandler>();
+    for (int i = 0; i < 4; i++)
+    {
+        ih->addDocument("doc" + std::to_string(i), "title" + std::to_string(i));
+        ih->addWordCount(i, 10);
+    }
+    ih->addWords("market", 0);
+    for (int i = 0; i < 5; i++)
+    {
+        ih->addWords("market", 1);
+    }
+    ih->addWords("market", 2);
+    ih->addWords("market", 2);
+    ih->addWords("other", 3);
+    ih->finalize();
+
+    QueryProcessor qp;
+    qp.setIndexHandler(ih);
+
+    SECTION("Ordered by score")
+    {
+        qp.parsingAnswer("market");
+        REQUIRE(qp.getPrintVectorSize() == 3);
+        REQUIRE(qp.getPrint(0) == "doc1");
+        REQUIRE(qp.getPrint(1) == "doc2");
+        REQUIRE(qp.getPrint(2) == "doc0");
+    }
+
+    SECTION("Length statistics computed once per index")
+    {
+        std::shared_ptr<const std::vector<float>> relative = ih->getRelativeWordCounts();
+        REQUIRE(relative != nullptr);
+        REQUIRE((*relative)[0] == 1);
+        QueryProcessor other;
+        other.setIndexHandler(ih);
+        qp.setScorer(std::make_shared<Bm25Scorer>());
+        REQUIRE(ih->getRelativeWordCounts() == relative);
+        REQUIRE(relative.use_count() == 4); // The index, this test and the scorers of both processors
+
+        // A new word count makes them stale until the next finalize()
+        ih->addWordCount(0, 20);
+        REQUIRE(ih->getRelativeWordCounts() == nullptr);
+        ih->finalize();
+        REQUIRE((*ih->getRelativeWordCounts())[0] == Approx(20 / 12.5));
+    }
+
+    SECTION("Bounded by k")
+    {
+        qp.setResultCount(2);
+        qp.parsingAnswer("market");
+        REQUIRE(qp.getPrintVectorSize() == 2);
+        REQUIRE(qp.getPrint(0) == "doc1");
+        REQUIRE(qp.getPrint(1) == "doc2");
+    }
+
+    SECTION("Planned query")
+    {
+        // All terms must match, whatever order they are typed in; negations only remove documents
+        REQUIRE(qp.parsingAnswer("market other").empty());
+        REQUIRE(qp.parsingAnswer("other market").empty());
+        REQUIRE(qp.parsingAnswer("other").size() == 1);
+        PostingView<DocId> result = qp.parsingAnswer("-other market");
+        REQUIRE(result.size() == 3);
+        REQUIRE(result.getFrequency(1) == 5);
+        REQUIRE(qp.parsingAnswer("-market").empty());
+    }
+
+    SECTION("OR and grouping")
+    {
+        // OR binds tighter than the implicit AND; parentheses group, and a group can be negated
+        PostingView<DocId> result = qp.parsingAnswer("market OR other");
+        REQUIRE(result.size() == 4);
+        REQUIRE(result.getFrequency(1) == 5);
+        REQUIRE(qp.getPrint(0) == "doc3"); // The rare term outweighs the common one
+        REQUIRE(qp.getPrint(1) == "doc1");
+        qp.clearPrintVector();
+        REQUIRE(qp.parsingAnswer("(market OR other) -other").size() == 3);
+        REQUIRE(qp.parsingAnswer("market (other OR market)").size() == 3);
+        REQUIRE(qp.parsingAnswer("other OR (market -market)").size() == 1);
+        REQUIRE(qp.parsingAnswer("(market OR nothing) other").empty());
+        REQUIRE(qp.parsingAnswer("-(market OR other)").empty());
+        REQUIRE(qp.parsingAnswer("OR market OR").size() == 3); // Dangling operators are ignored
+        REQUIRE(qp.parsingAnswer("((market) other OR market").size() == 3); // So are missing parentheses
+
+        // A group ranks like the same terms without one
+        qp.clearPrintVector();
+        qp.parsingAnswer("(market)");
+        REQUIRE(qp.getPrintVectorSize() == 3);
+        REQUIRE(qp.getPrint(0) == "doc1");
+        REQUIRE(qp.getPrint(1) == "doc2");
+        REQUIRE(qp.getPrint(2) == "doc0");
+    }
+
+    SECTION("tf-idf scorer")
+    {
+        qp.setScorer(std::make_shared<TfIdfScorer>());
+        qp.parsingAnswer("market");
+        REQUIRE(qp.getPrintVectorSize() == 3);
+        REQUIRE(qp.getPrint(0) == "doc1");
+        REQUIRE(qp.getPrint(2) == "doc0");
+    }
+}
+
+// Test case for phrase queries, matched by word positions
+TEST_CASE("phrases", "[QueryProcessor.h]")
+{
+    // Index texts by hand the way DocumentParser does: every token takes a position, stopwords are not indexed
+    const char *texts[] = {"bank of america reported profits", "america bank of the west",
+                           "the bank reported strong america", "bank america"};
+    StopWords stopWords;
+    auto index = [&](IndexHandler &ih, size_t first, size_t last)
+    {
+        for (size_t t = first; t < last; t++)
+        {
+            const char *text = texts[t];
+            DocId id = ih.addDocument(text, text);
+            int wordCount = 0;
+            Tokenizer tokens(text);
+            for (uint32_t position = 0; tokens.next(); position++)
+            {
+                std::string &word = tokens.buffer();
+                StemCache::shared().stem(word);
+                if (!stopWords.contains(word))
+                {
+                    ih.addWords(word, id);
+                    ih.addPosition(word, id, position);
+                    ih.addWordCount(id, ++wordCount);
+                }
+            }
+        }
+    };
+    auto build = [&](bool positional)
+    {
+        std::shared_ptr<IndexHandler> ih = std::make_shared<IndexHandler>();
+        if (positional)
+        {
+            ih->enablePositions();
+        }
+        index(*ih, 0, std::size(texts));
+        ih->finalize();
+        return ih;
+    };
+
+    QueryProcessor qp;
+    auto check = [&qp]()
+    {
+        // "of" is a stopword, but it still stands between "bank" and "america"
+        PostingView<DocId> result = qp.parsingAnswer("\"bank of america\"");
+        REQUIRE(result.size() == 1);
+        REQUIRE(result.getId(0) == 0);
+        REQUIRE(qp.parsingAnswer("\"bank america\"").getId(0) == 3);
+        REQUIRE(qp.parsingAnswer("\"Bank America\"~1").size() == 2);     // Up to one word in between
+        REQUIRE(qp.parsingAnswer("\"bank america\"~2").size() == 3);     // Up to two
+        REQUIRE(qp.parsingAnswer("bank -\"bank of america\"").size() == 3);
+        REQUIRE(qp.parsingAnswer("(\"bank of america\" OR west)").size() == 2);
+        REQUIRE(qp.parsingAnswer("\"america bank\" -(\"bank america\")").getId(0) == 1);
+        REQUIRE(qp.parsingAnswer("\"of the\" bank").size() == 4); // A phrase of stopwords is ignored
+        REQUIRE(qp.parsingAnswer("\"bank of\"").size() == 4);     // One word is a term
+        REQUIRE(qp.parsingAnswer("\"bank of america").size() == 1); // The missing quote is taken to be at the end
+    };
+
+    SECTION("In memory")
+    {
+        qp.setIndexHandler(build(true));
+        check();
+        qp.clearPrintVector();
+        qp.parsingAnswer("\"bank america\"~2");
+        REQUIRE(qp.getPrintVectorSize() == 3);
+    }
+
+    SECTION("After persistence")
+    {
+        build(true)->createPersistence();
+        qp.setIndexHandler(IndexHandler::openPersistence());
+        check();
+    }
+
+    SECTION("Added to after finalize")
+    {
+        // Lists compressed by the first finalize() are decoded again to take the later documents
+        std::shared_ptr<IndexHandler> ih = std::make_shared<IndexHandler>();
+        ih->enablePositions();
+        index(*ih, 0, 2);
+        ih->finalize();
+        index(*ih, 2, std::size(texts));
+        ih->finalize();
+        qp.setIndexHandler(ih);
+        check();
+    }
+
+    SECTION("Custom stopwords")
+    {
+        // Indexed without "of" only, so "the" takes part in phrases once the persisted list is loaded back
+        stopWords.assign("of");
+        std::shared_ptr<IndexHandler> built = build(true);
+        built->setStopWords(stopWords);
+        built->createPersistence();
+        qp.setIndexHandler(IndexHandler::openPersistence());
+        REQUIRE(qp.parsingAnswer("\"the bank\"").getId(0) == 2);
+        REQUIRE(qp.parsingAnswer("\"the bank\"").size() == 1);
+        REQUIRE(qp.parsingAnswer("\"bank of the west\"").getId(0) == 1);
+        REQUIRE(qp.parsingAnswer("\"bank of america\"").size() == 1);
+    }
+
+    SECTION("Without positions")
+    {
+        // A phrase falls back to matching documents with all of its words
+        qp.setIndexHandler(build(false));
+        REQUIRE(qp.parsingAnswer("\"bank of america\"").size() == 4);
+    }
+}
+
+// Test case for the query server's line protocol
+TEST_CASE("query server", "[QueryServer.h]")
+{
+    std::shared_ptr<IndexHandler> ih = std::make_shared<IndexHandler>();
+    ih->addDocument("doc0", "first\ttitle");
+    ih->addDocument("doc1", "second title");
+    ih->addWordCount(0, 4);
+    ih->addWordCount(1, 4);
+    ih->addWords("market", 0);
+    ih->addWords("market", 1);
+    ih->addWords("market", 1);
+    ih->finalize();
+
+    QueryServer server(ih);
+    std::istringstream in("market\nnothing\n-market\n");
+    std::ostringstream out;
+    server.serveStream(in, out);
+    REQUIRE(out.str() == "2\ndoc1\tsecond title\ndoc0\tfirst title\n0\n0\n");
+
+    // A file in the way of the socket that is not a socket is left alone
+    const std::string path = "test_query_server.sock";
+    std::ofstream(path) << "keep";
+    REQUIRE_FALSE(server.serveSocket(path));
+    std::ifstream kept(path);
+    std::string contents;
+    kept >> contents;
+    REQUIRE(contents == "keep");
+    std::remove(path.c_str());
+}
+
+// Test case for the scorers on their own
+TEST_CASE("scorers", "[Scorer.h]")
+{
+    // Two documents of very different lengths and one of average length
+    int lengths[] = {10, 100, 55};
+    double average = 55;
+
+    SECTION("BM25 favours the shorter document")
+    {
+        Bm25Scorer bm25;
+        bm25.setCorpus(lengths, 3, average, relativeLengths(lengths, 3, average));
+        bm25.setTerm(2);
+        REQUIRE(bm25.score(0, 3) > bm25.score(1, 3));
+        REQUIRE(bm25.score(0, 3) > bm25.score(0, 1));
+        REQUIRE(bm25.score(0, 1) > 0);
+    }
+
+    SECTION("BM25 saturates term frequency")
+    {
+        Bm25Scorer bm25(1.2, 0);
+        bm25.setCorpus(lengths, 3, average, relativeLengths(lengths, 3, average));
+        bm25.setTerm(1);
+        // Without length normalisation a single occurrence scores idf and no frequency can reach idf * (k1 + 1)
+        REQUIRE(bm25.score(2, 1000) < bm25.score(2, 1) * (1.2 + 1));
+    }
+
+    SECTION("BM25 references the relative lengths it is bound to")
+    {
+        std::shared_ptr<const std::vector<float>> relative = relativeLengths(lengths, 3, average);
+        Bm25Scorer shared, own;
+        shared.setCorpus(lengths, 3, average, relative);
+        own.setCorpus(lengths, 3, average, nullptr);
+        REQUIRE(relative.use_count() == 2); // Held by the scorer, not copied
+        shared.setTerm(2);
+        own.setTerm(2);
+        for (DocId id = 0; id < 3; id++)
+        {
+            REQUIRE(shared.score(id, 3) == own.score(id, 3));
+        }
+    }
+
+    SECTION("tf-idf")
+    {
+        TfIdfScorer tfidf;
+        tfidf.setCorpus(lengths, 3, average, nullptr);
+        tfidf.setTerm(3);
+        REQUIRE(tfidf.score(0, 5) == 0); // A term in every document carries no weight
+        tfidf.setTerm(1);
+        REQUIRE(tfidf.score(0, 5) == Approx(std::log2(3.0) * 5 / 10));
+    }
+}
+
+// Random ascending, duplicate-free document IDs: each ID below limit is kept with the given probability
+static std::vector<DocId> randomPostings(std::mt19937 &rng, DocId limit, double probability)
+{
+    std::bernoulli_distribution keep(probability);
+    std::vector<DocId> ids;
+    for (DocId id = 0; id < limit; id++)
+    {
+        if (keep(rng))
+        {
+            ids.push_back(id);
+        }
+    }
+    return ids;
+}
+
+// Test case for the intersection kernels against std::set_intersection
+TEST_CASE("intersection kernels", "[Intersect.h]")
+{
+    std::mt19937 rng(42);
+    QueryProcessor qp;
+    const double densities[] = {0.001, 0.01, 0.3, 0.5, 0.9};
+    for (double left : densities)
+    {
+        for (double right : densities)
+        {
+            std::vector<DocId> a = randomPostings(rng, 20000, left);
+            std::vector<DocId> b = randomPostings(rng, 20000, right);
+            std::vector<DocId> expected;
+            std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+
+            // Every kernel must report each common ID once, in order, with positions into both lists
+            auto check = [&](const std::vector<std::pair<size_t, size_t>> &found)
+            {
+                REQUIRE(found.size() == expected.size());
+                for (size_t k = 0; k < found.size(); k++)
+                {
+                    REQUIRE(a[found[k].first] == expected[k]);
+                    REQUIRE(b[found[k].second] == expected[k]);
+                }
+            };
+            std::vector<std::pair<size_t, size_t>> found;
+            auto collect = [&found](size_t i, size_t j)
+            { found.emplace_back(i, j); };
+
+            Intersect::intersect(a.data(), a.size(), b.data(), b.size(), collect);
+            check(found);
+            found.clear();
+            Intersect::blocks(a.data(), a.size(), b.data(), b.size(), collect);
+            check(found);
+            found.clear();
+            Intersect::galloping(a.data(), a.size(), b.data(), b.size(), collect);
+            check(found);
+            found.clear();
+            Intersect::scanning(a.data(), a.size(), b.data(), b.size(), collect);
+            check(found);
+            found.clear();
+
+            // Against a posting list, plain and compressed, positions into b are the entries' positions in the list
+            PostingList<DocId> list;
+            for (DocId id : b)
+            {
+                list.add(id);
+            }
+            Intersect::intersect(a.data(), a.size(), list.view(), collect);
+            check(found);
+            found.clear();
+            list.finalize();
+            REQUIRE((list.view().compressed() || b.empty()));
+            Intersect::intersect(a.data(), a.size(), list.view(), collect);
+            check(found);
+            found.clear();
+
+            // The query processor's operations on two compressed lists keep the frequencies of the first
+            PostingList<DocId> first;
+            for (DocId id : a)
+            {
+                first.add(id, 2);
+            }
+            first.finalize();
+            PostingList<DocId> both = qp.intersection(first.view(), list.view());
+            std::vector<DocId> ids;
+            both.forEach([&ids](DocId id, int freq)
+                         {
+                             ids.push_back(id);
+                             REQUIRE(freq == 2); });
+            REQUIRE(ids == expected);
+            REQUIRE(qp.complement(first.view(), list.view()).size() == a.size() - expected.size());
+        }
+    }
+}
+
+// Test case for ranked retrieval of documents with any of the terms, against scoring every document
+TEST_CASE("ranked any-term retrieval", "[QueryProcessor.h]")
+{
+    // Terms from very common to rare, with random frequencies and document lengths
+    std::mt19937 rng(5);
+    const DocId docCount = 20000;
+    const std::vector<std::pair<std::string, double>> vocabulary = {{"market", 0.5}, {"bond", 0.05}, {"yield", 0.01}, {"powell", 0.002}};
+    std::shared_ptr<IndexHandler> ih = std::make_shared<IndexHandler>();
+    std::uniform_int_distribution<int> length(20, 2000);
+    for (DocId id = 0; id < docCount; id++)
+    {
+        ih->addDocument("doc" + std::to_string(id), "title");
+        ih->addWordCount(id, length(rng));
+    }
+    std::geometric_distribution<int> extra(0.5);
+    std::vector<std::vector<int>> freqs; // freqs[t][id]: occurrences of vocabulary term t in document id
+    std::vector<std::string> keys;       // Stemmed vocabulary, as the query processor looks it up
+    for (const auto &term : vocabulary)
+    {
+        std::string key = term.first;
+        Porter2Stemmer::stem(key);
+        keys.push_back(key);
+        freqs.emplace_back(docCount, 0);
+        for (DocId id : randomPostings(rng, docCount, term.second))
+        {
+            freqs.back()[id] = 1 + extra(rng);
+            for (int i = 0; i < freqs.back()[id]; i++)
+            {
+                ih->addWords(key, id);
+            }
+        }
+    }
+    ih->finalize();
+
+    // Scores every document exhaustively, summing the terms in query order like the ranked retrieval does
+    auto expected = [&](Scorer &scorer, const std::vector<size_t> &terms, int negated, int k)
+    {
+        scorer.setCorpus(ih->getWordCounts(), ih->getDocSize(), ih->getAverageWordCount(), ih->getRelativeWordCounts());
+        std::vector<std::pair<double, DocId>> scored;
+        for (DocId id = 0; id < docCount; id++)
+        {
+            if (negated >= 0 && freqs[negated][id] > 0)
+            {
+                continue;
+            }
+            double score = 0;
+            bool matched = false;
+            for (size_t t : terms)
+            {
+                if (freqs[t][id] > 0)
+                {
+                    scorer.setTerm(ih->getWords(keys[t]).size());
+                    score += scorer.score(id, freqs[t][id]);
+                    matched = true;
+                }
+            }
+            if (matched)
+            {
+                scored.emplace_back(-score, id); // Best first: highest score, then lowest ID
+            }
+        }
+        std::sort(scored.begin(), scored.end());
+        std::vector<DocId> ids;
+        for (size_t i = 0; i < scored.size() && (int)i < k; i++)
+        {
+            ids.push_back(scored[i].second);
+        }
+        return ids;
+    };
+
+    QueryProcessor qp;
+    qp.setIndexHandler(ih);
+    qp.setMatchMode(QueryProcessor::MATCH_ANY);
+    for (int k : {1, 15, 200})
+    {
+        qp.setResultCount(k);
+        std::shared_ptr<Scorer> bm25 = std::make_shared<Bm25Scorer>(), tfidf = std::make_shared<TfIdfScorer>();
+        for (const std::shared_ptr<Scorer> &scorer : {bm25, tfidf})
+        {
+            qp.setScorer(scorer);
+            qp.clearPrintVector();
+            qp.parsingAnswer("market bond yield powell");
+            REQUIRE(qp.getResultIds() == expected(*scorer, {0, 1, 2, 3}, -1, k));
+            qp.clearPrintVector();
+            qp.parsingAnswer("powell market");
+            REQUIRE(qp.getResultIds() == expected(*scorer, {3, 0}, -1, k));
+            qp.clearPrintVector();
+            PostingView<DocId> result = qp.parsingAnswer("market -bond yield");
+            REQUIRE(qp.getResultIds() == expected(*scorer, {0, 2}, 1, k));
+            REQUIRE(result.size() == qp.getResultIds().size());
+        }
+    }
+
+    // Terms that are not indexed match nothing, and negations alone still match nothing
+    qp.clearPrintVector();
+    REQUIRE(qp.parsingAnswer("nosuchword").empty());
+    REQUIRE(qp.parsingAnswer("-market").empty());
 }
@@ -0,0 +1,106 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "StemCache.h"
+#include "porter2_stemmer.h"
+#include <random>
+#include <thread>
+#include <vector>
+
+// Words with many suffix forms, plus a few the stemmer leaves alone or truncates
+static const std::vector<std::string> WORDS = {
+    "running", "runner", "ran", "generously", "happiness", "nationality", "relational", "conditional", "rational",
+    "valenci", "hopeful", "goodness", "markets", "marketing", "economies", "economy", "dying", "skis", "news",
+    "a", "an", "going", "communism", "generalization", "'quoted", "abcdefghijklmnopqrstuvwxyzabcdefghijklmnop"};
+
+static std::string directStem(std::string word)
+{
+    Porter2Stemmer::stem(word);
+    return word;
+}
+
+// Test case for returning the stemmer's result
+TEST_CASE("same stems as the stemmer", "[StemCache]")
+{
+    StemCache cache;
+    for (int round = 0; round < 3; round++) // The first round fills the cache, the others hit it
+    {
+        for (const std::string &original : WORDS)
+        {
+            std::string word = original;
+            cache.stem(word);
+            REQUIRE(word == directStem(original));
+        }
+    }
+}
+
+// Test case for the hit and miss counters
+TEST_CASE("counters", "[StemCache]")
+{
+    StemCache cache;
+    REQUIRE(cache.getHitRate() == 0);
+    std::string word = "running";
+    cache.stem(word);
+    REQUIRE(cache.getMisses() == 1);
+    REQUIRE(cache.getHits() == 0);
+    for (int i = 0; i < 3; i++)
+    {
+        word = "running";
+        cache.stem(word);
+        REQUIRE(word == "run");
+    }
+    REQUIRE(cache.getHits() == 3);
+    REQUIRE(cache.getHitRate() == 0.75);
+
+    // Short words bypass the cache
+    word = "an";
+    cache.stem(word);
+    REQUIRE(cache.getHits() + cache.getMisses() == 4);
+
+    // A tiny cache evicts, but never returns a wrong stem
+    StemCache tiny(16);
+    for (int round = 0; round < 2; round++)
+    {
+        for (const std::string &original : WORDS)
+        {
+            std::string stemmed = original;
+            tiny.stem(stemmed);
+            REQUIRE(stemmed == directStem(original));
+        }
+    }
+}
+
+// Test case for sharing one cache between threads
+TEST_CASE("concurrent use", "[StemCache]")
+{
+    StemCache cache(256);
+    std::vector<std::string> expected;
+    for (const std::string &word : WORDS)
+    {
+        expected.push_back(directStem(word));
+    }
+    std::vector<std::thread> threads;
+    std::vector<int> wrong(4, 0);
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&cache, &expected, &wrong, t]()
+                             {
+                                 std::mt19937 rng(t);
+                                 std::uniform_int_distribution<size_t> pick(0, WORDS.size() - 1);
+                                 for (int i = 0; i < 20000; i++)
+                                 {
+                                     size_t w = pick(rng);
+                                     std::string word = WORDS[w];
+                                     cache.stem(word);
+                                     wrong[t] += word != expected[w];
+                                 } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    for (int count : wrong)
+    {
+        REQUIRE(count == 0);
+    }
+    REQUIRE(cache.getHitRate() > 0.5);
+}
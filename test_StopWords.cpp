@@ -0,0 +1,70 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "StopWords.h"
+#include <cstdio>
+#include <fstream>
+
+// Test case for the built-in list
+TEST_CASE("built-in list", "[StopWords]")
+{
+    StopWords stopWords;
+    REQUIRE(stopWords.size() == 635);
+    REQUIRE(stopWords.contains("the"));
+    REQUIRE(stopWords.contains("able"));
+    REQUIRE(stopWords.contains("notwithstanding")); // The longest word
+    REQUIRE(stopWords.contains("zero"));
+    REQUIRE(stopWords.contains("ain't"));
+
+    REQUIRE_FALSE(stopWords.contains(""));
+    REQUIRE_FALSE(stopWords.contains("market"));
+    REQUIRE_FALSE(stopWords.contains("th3"));
+    REQUIRE_FALSE(stopWords.contains("thee"));
+    REQUIRE_FALSE(stopWords.contains("notwithstandings"));
+
+    // Probing with a view into a larger buffer
+    std::string_view text = "the market";
+    REQUIRE(stopWords.contains(text.substr(0, 3)));
+    REQUIRE_FALSE(stopWords.contains(text.substr(4)));
+}
+
+// Test case for loading a custom list
+TEST_CASE("custom list", "[StopWords]")
+{
+    const std::string path = "test_stopwords.txt";
+    {
+        std::ofstream out(path);
+        out << "Market bond\n\tstock  market\n";
+    }
+    StopWords stopWords;
+    REQUIRE(stopWords.load(path));
+    std::remove(path.c_str());
+    REQUIRE(stopWords.size() == 3); // Words are lowercased and duplicates kept once
+    REQUIRE(stopWords.contains("market"));
+    REQUIRE(stopWords.contains("bond"));
+    REQUIRE(stopWords.contains("stock"));
+    REQUIRE_FALSE(stopWords.contains("the"));
+
+    // Copies and moves keep their own list; a moved-from list is the built-in one again
+    StopWords copy(stopWords);
+    REQUIRE(copy.contains("bond"));
+    StopWords moved(std::move(stopWords));
+    REQUIRE(moved.contains("bond"));
+    REQUIRE(stopWords.contains("the"));
+    copy = StopWords();
+    REQUIRE(copy.contains("the"));
+    REQUIRE_FALSE(copy.contains("bond"));
+
+    // The list survives a round trip through its text, the way an index file stores it
+    StopWords restored;
+    restored.assign(moved.text());
+    REQUIRE(restored.size() == 3);
+    REQUIRE(restored.contains("market"));
+    REQUIRE_FALSE(restored.contains("the"));
+    restored.assign(StopWords().text());
+    REQUIRE(restored.size() == 635);
+    REQUIRE(restored.contains("ain't"));
+
+    // A missing file leaves the list as it was
+    REQUIRE_FALSE(moved.load("no_such_stopword_file.txt"));
+    REQUIRE(moved.contains("stock"));
+}
@@ -0,0 +1,151 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "Tokenizer.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+// The tokens the parser produced before it had a tokenizer: split with >>, drop non-letters, lowercase
+static std::vector<std::string> streamTokens(const std::string &text)
+{
+    std::vector<std::string> tokens;
+    std::istringstream iss(text);
+    std::string word;
+    while (iss >> word)
+    {
+        word.erase(std::remove_if(word.begin(), word.end(), [](char c)
+                                  { return !isalpha(c); }),
+                   word.end());
+        std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+        tokens.push_back(word);
+    }
+    return tokens;
+}
+
+static std::vector<std::string> tokenize(const std::string &text)
+{
+    std::vector<std::string> tokens;
+    Tokenizer tokenizer(text);
+    while (tokenizer.next())
+    {
+        tokens.emplace_back(tokenizer.token());
+    }
+    return tokens;
+}
+
+// Random text from letters, digits, punctuation and whitespace
+static std::string randomText(size_t length, unsigned seed)
+{
+    const std::string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789.,;:'-()$%      \t\n\r";
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+    std::string text;
+    for (size_t i = 0; i < length; i++)
+    {
+        text += alphabet[pick(rng)];
+    }
+    return text;
+}
+
+// Random prose-like text: words of 1 to 12 letters, some capitalized or followed by punctuation
+static std::string randomProse(size_t length, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> wordLength(1, 12), letter(0, 25), percent(0, 99);
+    std::string text;
+    while (text.size() < length)
+    {
+        int n = wordLength(rng);
+        for (int i = 0; i < n; i++)
+        {
+            text += (i == 0 && percent(rng) < 10 ? 'A' : 'a') + letter(rng);
+        }
+        if (percent(rng) < 15)
+        {
+            text += percent(rng) < 50 ? ',' : '.';
+        }
+        text += percent(rng) < 5 ? '\n' : ' ';
+    }
+    return text;
+}
+
+// Test case for splitting and normalizing
+TEST_CASE("tokens", "[Tokenizer]")
+{
+    REQUIRE(tokenize("").empty());
+    REQUIRE(tokenize(" \t\n ").empty());
+    REQUIRE(tokenize("Hello, World!") == std::vector<std::string>{"hello", "world"});
+    REQUIRE(tokenize("  U.S.  Fed's\trate-cut\n") == std::vector<std::string>{"us", "feds", "ratecut"});
+
+    // Tokens without letters are still reported, as empty tokens
+    REQUIRE(tokenize("up 2.5% today") == std::vector<std::string>{"up", "", "today"});
+
+    // Only the given length is scanned
+    std::string text = "market crash";
+    Tokenizer tokenizer(text.data(), 6);
+    REQUIRE(tokenizer.next());
+    REQUIRE(tokenizer.token() == "market");
+    REQUIRE_FALSE(tokenizer.next());
+}
+
+// Test case comparing the tokenizer with the stream-based pipeline it replaced
+TEST_CASE("same tokens as the stream pipeline", "[Tokenizer]")
+{
+    for (unsigned seed = 0; seed < 20; seed++)
+    {
+        std::string text = randomText(5000, seed);
+        REQUIRE(tokenize(text) == streamTokens(text));
+        text = randomProse(5000, seed);
+        REQUIRE(tokenize(text) == streamTokens(text));
+    }
+}
+
+// Test case for reusing the scratch buffer
+TEST_CASE("scratch buffer", "[Tokenizer]")
+{
+    std::string text = "Extraordinarily long words first, then short ones";
+    Tokenizer tokenizer(text);
+    REQUIRE(tokenizer.next());
+    const char *storage = tokenizer.buffer().data();
+    while (tokenizer.next())
+    {
+        REQUIRE(tokenizer.buffer().data() == storage); // Shorter tokens fit the buffer the first one grew
+    }
+
+    // The buffer can be edited in place, e.g. by a stemmer
+    Tokenizer editable("Running");
+    REQUIRE(editable.next());
+    editable.buffer().resize(3);
+    REQUIRE(editable.token() == "run");
+}
+
+// Throughput of the tokenizer and of the stream pipeline on the same text, in MB/s on one core.
+// Hidden by default; run with: ./test_Tokenizer [benchmark]
+TEST_CASE("throughput", "[.benchmark]")
+{
+    std::string text = randomProse(8 << 20, 1);
+    auto megabytesPerSecond = [&text](auto &&run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        size_t tokens = run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        REQUIRE(tokens > 0);
+        return text.size() / 1e6 / elapsed.count();
+    };
+    double tokenizer = megabytesPerSecond([&text]()
+                                          {
+                                              size_t count = 0;
+                                              Tokenizer tokens(text);
+                                              while (tokens.next())
+                                              {
+                                                  count += !tokens.token().empty();
+                                              }
+                                              return count; });
+    double stream = megabytesPerSecond([&text]()
+                                       { return streamTokens(text).size(); });
+    std::cout << "Tokenizer: " << tokenizer << " MB/s, stream pipeline: " << stream << " MB/s" << std::endl;
+}